@@ -0,0 +1,29 @@
+# Times the header and module compile benchmarks of an already configured build directory:
+#   cmake -D BUILD_DIR=<build directory> [-D JOBS=<n>] -P benchmark/compile_time.cmake
+# The build directory must be configured with SDLWRAP_BUILD_MODULE and SDLWRAP_BUILD_COMPILE_BENCHMARK on.
+if (NOT DEFINED BUILD_DIR)
+    message(FATAL_ERROR "set BUILD_DIR to a configured build directory")
+endif()
+if (NOT DEFINED JOBS)
+    set(JOBS 1)
+endif()
+
+# the libraries and the module interface are built up front so that only the consumers are timed
+execute_process(
+    COMMAND ${CMAKE_COMMAND} --build ${BUILD_DIR} --target Core CoreModule
+    COMMAND_ERROR_IS_FATAL ANY
+)
+
+foreach (variant header module)
+    set(target compile_benchmark_${variant})
+    file(REMOVE_RECURSE ${BUILD_DIR}/benchmark/CMakeFiles/${target}.dir)
+    string(TIMESTAMP start "%s%f")
+    execute_process(
+        COMMAND ${CMAKE_COMMAND} --build ${BUILD_DIR} --target ${target} --parallel ${JOBS}
+        OUTPUT_QUIET
+        COMMAND_ERROR_IS_FATAL ANY
+    )
+    string(TIMESTAMP stop "%s%f")
+    math(EXPR elapsed_ms "(${stop} - ${start}) / 1000")
+    message(STATUS "${variant}: ${elapsed_ms} ms")
+endforeach()
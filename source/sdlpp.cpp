@@ -1,5 +1,8 @@
 #include "sdlpp.h"
 
+#include <gsl/gsl>
+
+#include <algorithm>
 #include <optional>
 
 namespace sdl {
@@ -9,6 +12,11 @@ void add_event_watch(EventFilterCallback callback, void* user_data) noexcept
     SDL_AddEventWatch(callback, user_data);
 }
 
+void remove_event_watch(EventFilterCallback callback, void* user_data) noexcept
+{
+    SDL_DelEventWatch(callback, user_data);
+}
+
 void set_event_filter(EventFilterCallback callback, void* user_data) noexcept
 {
     SDL_SetEventFilter(callback, user_data);
@@ -108,7 +116,7 @@ Uint32 register_events(int n_events)
     return event_id;
 }
 
-bool push_event(SDL_Event& event)
+bool push_event(Event& event)
 {
     int status = SDL_PushEvent(&event);
     if (status < 0) {
@@ -117,27 +125,29 @@ bool push_event(SDL_Event& event)
     return status == 1;
 }
 
-RWOpsUniquePtr rw_from_file(const char* filename, const char* mode)
+RWOpsUniquePtr rw_from_file(const char* filename, const char* mode SDLWRAP_SITE_DEFINITION)
 {
     RWOpsUniquePtr rw_ops{SDL_RWFromFile(filename, mode)};
     if (rw_ops == nullptr) {
         throw GenericError{};
     }
+    SDLWRAP_TRACK(accounting::ResourceType::rw_ops, rw_ops.get(), 0);
     return rw_ops;
 }
 
-RWOpsUniquePtr rw_from_file(const std::string& filename, const std::string& mode)
+RWOpsUniquePtr rw_from_file(const std::string& filename, const std::string& mode SDLWRAP_SITE_DEFINITION)
 {
-    return rw_from_file(filename.c_str(), mode.c_str());
+    return rw_from_file(filename.c_str(), mode.c_str() SDLWRAP_SITE_ARGUMENT);
 }
 
 #ifdef HAVE_STDIO_H
-RWOpsUniquePtr rw_from_file(FILE* file)
+RWOpsUniquePtr rw_from_file(FILE* file SDLWRAP_SITE_DEFINITION)
 {
     RWOpsUniquePtr rw_ops{SDL_RWFromFP(file, SDL_FALSE)};
     if (rw_ops == nullptr) {
         throw GenericError{};
     }
+    SDLWRAP_TRACK(accounting::ResourceType::rw_ops, rw_ops.get(), 0);
     return rw_ops;
 }
 #endif
@@ -154,87 +164,211 @@ bool is_point_in_rectangle<Point<float>, Rectangle<float>>(const Point<float> po
     return SDL_PointInFRect(&point, &rectangle) == SDL_TRUE;
 }
 
-WindowUniquePtr make_window(const char* title, int x_position, int y_position, int width, int height, Uint32 flags)
+WindowUniquePtr make_window(
+    const char* title, int x_position, int y_position, int width, int height, Uint32 flags SDLWRAP_SITE_DEFINITION
+)
 {
     WindowUniquePtr window{SDL_CreateWindow(title, x_position, y_position, width, height, flags)};
     if (window == nullptr) {
         throw GenericError{};
     }
+    SDLWRAP_TRACK(accounting::ResourceType::window, window.get(), 0);
     return window;
 }
 
-WindowUniquePtr make_window(const WindowConfig& config)
+WindowUniquePtr make_window(const WindowConfig& config SDLWRAP_SITE_DEFINITION)
 {
-    return make_window(config.title, config.x_position, config.y_position, config.width, config.height, config.flags);
+    return make_window(
+        config.title, config.x_position, config.y_position, config.width, config.height,
+        config.flags SDLWRAP_SITE_ARGUMENT
+    );
 }
 
-RendererUniquePtr make_renderer(SDL_Window* window, int index, Uint32 flags)
+RendererUniquePtr make_renderer(SDL_Window* window, int index, Uint32 flags SDLWRAP_SITE_DEFINITION)
 {
     RendererUniquePtr renderer{SDL_CreateRenderer(window, index, flags)};
     if (renderer == nullptr) {
         throw GenericError{};
     }
+    SDLWRAP_TRACK(accounting::ResourceType::renderer, renderer.get(), 0);
     return renderer;
 }
 
-RendererUniquePtr make_renderer(SDL_Window* window, const RendererConfig& config)
+RendererUniquePtr make_renderer(SDL_Window* window, const RendererConfig& config SDLWRAP_SITE_DEFINITION)
 {
-    return make_renderer(window, config.index, config.flags);
+    return make_renderer(window, config.index, config.flags SDLWRAP_SITE_ARGUMENT);
 }
 
-TextureUniquePtr make_texture(SDL_Renderer* renderer, Uint32 format, int access, int width, int height)
+TextureUniquePtr
+make_texture(SDL_Renderer* renderer, Uint32 format, int access, int width, int height SDLWRAP_SITE_DEFINITION)
 {
     TextureUniquePtr texture{SDL_CreateTexture(renderer, format, access, width, height)};
     if (texture == nullptr) {
         throw GenericError{};
     }
+    SDLWRAP_TRACK(accounting::ResourceType::texture, texture.get(), accounting::estimate_bytes(format, width, height));
     return texture;
 }
 
-TextureUniquePtr make_texture_from_surface(SDL_Renderer* renderer, SDL_Surface* surface)
+TextureUniquePtr make_texture_from_surface(SDL_Renderer* renderer, SDL_Surface* surface SDLWRAP_SITE_DEFINITION)
 {
     TextureUniquePtr texture{SDL_CreateTextureFromSurface(renderer, surface)};
     if (texture == nullptr) {
         throw GenericError{};
     }
+    SDLWRAP_TRACK(accounting::ResourceType::texture, texture.get(), accounting::estimate_bytes(texture.get()));
+    return texture;
+}
+
+TextureUniquePtr
+make_texture_from_native_surface(SDL_Renderer* renderer, SDL_Surface* surface SDLWRAP_SITE_DEFINITION)
+{
+    TextureUniquePtr texture = make_texture(
+        renderer, surface->format->format, SDL_TEXTUREACCESS_STATIC, surface->w, surface->h SDLWRAP_SITE_ARGUMENT
+    );
+    if (SDL_MUSTLOCK(surface) && SDL_LockSurface(surface) != 0) {
+        throw GenericError{};
+    }
+    const int status = SDL_UpdateTexture(texture.get(), nullptr, surface->pixels, surface->pitch);
+    if (SDL_MUSTLOCK(surface)) {
+        SDL_UnlockSurface(surface);
+    }
+    if (status != 0) {
+        throw GenericError{};
+    }
+    if (SDL_ISPIXELFORMAT_ALPHA(surface->format->format) &&
+        SDL_SetTextureBlendMode(texture.get(), SDL_BLENDMODE_BLEND) != 0) {
+        throw GenericError{};
+    }
     return texture;
 }
 
-TextureUniquePtr Renderer::make_texture(Uint32 format, int access, int width, int height) const
+TextureUniquePtr
+Renderer::make_texture(Uint32 format, int access, int width, int height SDLWRAP_SITE_DEFINITION) const
 {
-    return ::sdl::make_texture(get_pointer(), format, access, width, height);
+    return ::sdl::make_texture(get_pointer(), format, access, width, height SDLWRAP_SITE_ARGUMENT);
 }
 
-TextureUniquePtr Renderer::make_texture(const Texture::Properties& properties) const
+TextureUniquePtr Renderer::make_texture(const Texture::Properties& properties SDLWRAP_SITE_DEFINITION) const
 {
     return ::sdl::make_texture(
-        get_pointer(), properties.format, properties.access, properties.width, properties.height
+        get_pointer(), properties.format, properties.access, properties.width,
+        properties.height SDLWRAP_SITE_ARGUMENT
     );
 }
 
-TextureUniquePtr Renderer::make_texture_from_surface(SDL_Surface* surface) const
+TextureUniquePtr Renderer::make_texture_from_surface(SDL_Surface* surface SDLWRAP_SITE_DEFINITION) const
+{
+    return ::sdl::make_texture_from_surface(get_pointer(), surface SDLWRAP_SITE_ARGUMENT);
+}
+
+TextureUniquePtr Renderer::make_texture_from_native_surface(SDL_Surface* surface SDLWRAP_SITE_DEFINITION) const
+{
+    return ::sdl::make_texture_from_native_surface(get_pointer(), surface SDLWRAP_SITE_ARGUMENT);
+}
+
+SurfaceUniquePtr make_surface(int width, int height, Uint32 format SDLWRAP_SITE_DEFINITION)
 {
-    return ::sdl::make_texture_from_surface(get_pointer(), surface);
+    SurfaceUniquePtr surface{SDL_CreateRGBSurfaceWithFormat(0, width, height, 0, format)};
+    if (surface == nullptr) {
+        throw GenericError{};
+    }
+    SDLWRAP_TRACK(accounting::ResourceType::surface, surface.get(), accounting::estimate_bytes(surface.get()));
+    return surface;
 }
 
-SurfaceUniquePtr load_bmp(const std::string& filename)
+SurfaceUniquePtr load_bmp(const std::string& filename SDLWRAP_SITE_DEFINITION)
 {
     SurfaceUniquePtr image{SDL_LoadBMP(filename.c_str())};
     if (image == nullptr) {
         throw GenericError{};
     }
+    SDLWRAP_TRACK(accounting::ResourceType::surface, image.get(), accounting::estimate_bytes(image.get()));
     return image;
 }
 
-SurfaceUniquePtr convert_surface(SurfaceUniquePtr surface, const SDL_PixelFormat* format, Uint32 flags)
+void save_bmp_rw(SDL_Surface* surface, SDL_RWops* destination)
+{
+    if (SDL_SaveBMP_RW(surface, destination, 0) != 0) {
+        throw GenericError{};
+    }
+}
+
+void save_bmp(SDL_Surface* surface, const std::string& filename)
+{
+    save_bmp_rw(surface, rw_from_file(filename, "wb").get());
+}
+
+SurfaceUniquePtr
+convert_surface(SurfaceUniquePtr surface, const SDL_PixelFormat* format, Uint32 flags SDLWRAP_SITE_DEFINITION)
 {
     SurfaceUniquePtr converted_surface{SDL_ConvertSurface(surface.get(), format, flags)};
     if (converted_surface == nullptr) {
         throw GenericError{};
     }
+    SDLWRAP_TRACK(
+        accounting::ResourceType::surface, converted_surface.get(), accounting::estimate_bytes(converted_surface.get())
+    );
+    return converted_surface;
+}
+
+SurfaceUniquePtr
+convert_surface_format(SurfaceUniquePtr surface, Uint32 format, Uint32 flags SDLWRAP_SITE_DEFINITION)
+{
+    SurfaceUniquePtr converted_surface{SDL_ConvertSurfaceFormat(surface.get(), format, flags)};
+    if (converted_surface == nullptr) {
+        throw GenericError{};
+    }
+    SDLWRAP_TRACK(
+        accounting::ResourceType::surface, converted_surface.get(), accounting::estimate_bytes(converted_surface.get())
+    );
     return converted_surface;
 }
 
+bool surface_has_alpha(const SDL_Surface& surface) noexcept
+{
+    return SDL_ISPIXELFORMAT_ALPHA(surface.format->format) || SDL_HasColorKey(const_cast<SDL_Surface*>(&surface));
+}
+
+Uint32 select_texture_format(const SDL_RendererInfo& info, Uint32 surface_format, bool needs_alpha)
+{
+    const std::span<const Uint32> formats{info.texture_formats, info.num_texture_formats};
+    const auto is_packed = [](Uint32 format) {
+        return !SDL_ISPIXELFORMAT_FOURCC(format) && !SDL_ISPIXELFORMAT_INDEXED(format);
+    };
+
+    if (std::find(formats.begin(), formats.end(), surface_format) != formats.end() &&
+        (!needs_alpha || SDL_ISPIXELFORMAT_ALPHA(surface_format))) {
+        return surface_format;
+    }
+    // renderers list their formats in order of preference
+    const auto preferred = std::find_if(formats.begin(), formats.end(), [&](Uint32 format) {
+        return is_packed(format) && SDL_ISPIXELFORMAT_ALPHA(format) == needs_alpha;
+    });
+    if (preferred != formats.end()) {
+        return *preferred;
+    }
+    const auto any_packed = std::find_if(formats.begin(), formats.end(), [&](Uint32 format) {
+        return is_packed(format) && (!needs_alpha || SDL_ISPIXELFORMAT_ALPHA(format));
+    });
+    if (any_packed != formats.end()) {
+        return *any_packed;
+    }
+    return needs_alpha ? Uint32{SDL_PIXELFORMAT_ARGB8888} : Uint32{SDL_PIXELFORMAT_RGB888};
+}
+
+NativeSurface
+convert_to_native_surface(SurfaceUniquePtr surface, const SDL_RendererInfo& info SDLWRAP_SITE_DEFINITION)
+{
+    const Uint32 source_format = surface->format->format;
+    const Uint32 texture_format = select_texture_format(info, source_format, surface_has_alpha(*surface));
+    const bool convert = texture_format != source_format || SDL_HasColorKey(surface.get());
+    if (convert) {
+        surface = convert_surface_format(std::move(surface), texture_format, 0 SDLWRAP_SITE_ARGUMENT);
+    }
+    return NativeSurface{std::move(surface), FormatConversion{source_format, texture_format, convert}};
+}
+
 template <>
 void Renderer::draw_point<int>(int point_x, int point_y) const
 {
@@ -263,6 +397,20 @@ void Renderer::draw_point<Point<float>>(Point<float> point) const
     draw_point(point.x, point.y);
 }
 
+void Renderer::draw_points(std::span<const Point<int>> points) const
+{
+    if (SDL_RenderDrawPoints(get_pointer(), points.data(), gsl::narrow<int>(points.size())) != 0) {
+        throw GenericError{};
+    }
+}
+
+void Renderer::draw_points(std::span<const Point<float>> points) const
+{
+    if (SDL_RenderDrawPointsF(get_pointer(), points.data(), gsl::narrow<int>(points.size())) != 0) {
+        throw GenericError{};
+    }
+}
+
 void Renderer::draw_line(int x_begin, int y_begin, int x_end, int y_end) const
 {
     if (SDL_RenderDrawLine(get_pointer(), x_begin, y_begin, x_end, y_end) != 0) {
@@ -275,6 +423,62 @@ void Renderer::draw_line(Point<int> begin, Point<int> end) const
     draw_line(begin.x, begin.y, end.x, end.y);
 }
 
+void Renderer::draw_line_f(float x_begin, float y_begin, float x_end, float y_end) const
+{
+    if (SDL_RenderDrawLineF(get_pointer(), x_begin, y_begin, x_end, y_end) != 0) {
+        throw GenericError{};
+    }
+}
+
+void Renderer::draw_line_f(Point<float> begin, Point<float> end) const
+{
+    draw_line_f(begin.x, begin.y, end.x, end.y);
+}
+
+void Renderer::draw_lines(std::span<const Point<int>> points) const
+{
+    if (SDL_RenderDrawLines(get_pointer(), points.data(), gsl::narrow<int>(points.size())) != 0) {
+        throw GenericError{};
+    }
+}
+
+void Renderer::draw_lines(std::span<const Point<float>> points) const
+{
+    if (SDL_RenderDrawLinesF(get_pointer(), points.data(), gsl::narrow<int>(points.size())) != 0) {
+        throw GenericError{};
+    }
+}
+
+template <>
+void Renderer::draw_rectangle<Rectangle<int>>(const Rectangle<int>& rectangle) const
+{
+    if (SDL_RenderDrawRect(get_pointer(), &rectangle) != 0) {
+        throw GenericError{};
+    }
+}
+
+template <>
+void Renderer::draw_rectangle<Rectangle<float>>(const Rectangle<float>& rectangle) const
+{
+    if (SDL_RenderDrawRectF(get_pointer(), &rectangle) != 0) {
+        throw GenericError{};
+    }
+}
+
+void Renderer::draw_rectangles(std::span<const Rectangle<int>> rectangles) const
+{
+    if (SDL_RenderDrawRects(get_pointer(), rectangles.data(), gsl::narrow<int>(rectangles.size())) != 0) {
+        throw GenericError{};
+    }
+}
+
+void Renderer::draw_rectangles(std::span<const Rectangle<float>> rectangles) const
+{
+    if (SDL_RenderDrawRectsF(get_pointer(), rectangles.data(), gsl::narrow<int>(rectangles.size())) != 0) {
+        throw GenericError{};
+    }
+}
+
 template <>
 void Renderer::fill_rectangle<Rectangle<int>>(const Rectangle<int>& rectangle)
 {
@@ -293,14 +497,24 @@ void Renderer::fill_rectangle<Rectangle<float>>(const Rectangle<float>& rectangl
 
 template <>
 void Renderer::fill_rectangles<Rectangle<int>>(std::span<Rectangle<int>> rectangles)
+{
+    fill_rectangles(std::span<const Rectangle<int>>{rectangles});
+}
+
+template <>
+void Renderer::fill_rectangles<Rectangle<float>>(std::span<Rectangle<float>> rectangles)
+{
+    fill_rectangles(std::span<const Rectangle<float>>{rectangles});
+}
+
+void Renderer::fill_rectangles(std::span<const Rectangle<int>> rectangles) const
 {
     if (SDL_RenderFillRects(get_pointer(), rectangles.data(), gsl::narrow<int>(rectangles.size())) != 0) {
         throw GenericError{};
     }
 }
 
-template <>
-void Renderer::fill_rectangles<Rectangle<float>>(std::span<Rectangle<float>> rectangles)
+void Renderer::fill_rectangles(std::span<const Rectangle<float>> rectangles) const
 {
     if (SDL_RenderFillRectsF(get_pointer(), rectangles.data(), gsl::narrow<int>(rectangles.size())) != 0) {
         throw GenericError{};
@@ -327,4 +541,46 @@ void Renderer::copy<Rectangle<float>>(
     }
 }
 
+void Renderer::render_geometry(
+    SDL_Texture* texture, std::span<const SDL_Vertex> vertices, std::span<const int> indices
+) const
+{
+    if (SDL_RenderGeometry(
+            get_pointer(),
+            texture,
+            vertices.data(),
+            gsl::narrow<int>(vertices.size()),
+            indices.empty() ? nullptr : indices.data(),
+            gsl::narrow<int>(indices.size())
+        ) != 0) {
+        throw GenericError{};
+    }
+}
+
+void Renderer::render_geometry(
+    SDL_Texture* texture,
+    std::span<const float> positions,
+    std::span<const Color> colors,
+    std::span<const float> texture_coordinates,
+    std::span<const int> indices
+) const
+{
+    if (SDL_RenderGeometryRaw(
+            get_pointer(),
+            texture,
+            positions.data(),
+            2 * sizeof(float),
+            colors.data(),
+            sizeof(Color),
+            texture_coordinates.empty() ? nullptr : texture_coordinates.data(),
+            2 * sizeof(float),
+            gsl::narrow<int>(colors.size()),
+            indices.empty() ? nullptr : indices.data(),
+            gsl::narrow<int>(indices.size()),
+            sizeof(int)
+        ) != 0) {
+        throw GenericError{};
+    }
+}
+
 } // namespace sdl
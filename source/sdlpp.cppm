@@ -0,0 +1,249 @@
+// Named module exporting the SDLWrap::Core API, built when SDLWRAP_BUILD_MODULE is on. The headers stay the
+// reference interface and the fallback for compilers without module support; this unit only re-exports their
+// declarations. The SDL C API itself is not exported, so importers still include <SDL.h> for SDL_* types and macros.
+module;
+
+#include "sdlpp.h"
+#include "sdlpp_accounting.h"
+#include "sdlpp_audio.h"
+#include "sdlpp_capture.h"
+#include "sdlpp_color_lut.h"
+#include "sdlpp_draw_buffer.h"
+#include "sdlpp_event_log.h"
+#include "sdlpp_font.h"
+#include "sdlpp_input.h"
+#include "sdlpp_mipmap.h"
+#include "sdlpp_particles.h"
+#include "sdlpp_recorder.h"
+#include "sdlpp_render_thread.h"
+#include "sdlpp_tilemap.h"
+
+export module sdlwrap.core;
+
+// sdlpp.h
+export namespace sdl {
+
+using sdl::GenericError;
+
+using sdl::Event;
+using sdl::EventFilterCallback;
+using sdl::EventType;
+using sdl::add_event_watch;
+using sdl::flush_all_events;
+using sdl::flush_events;
+using sdl::get_event_filter;
+using sdl::poll_event;
+using sdl::pump_events;
+using sdl::push_event;
+using sdl::register_events;
+using sdl::remove_event_watch;
+using sdl::set_event_filter;
+using sdl::wait_event;
+
+using sdl::RWOps;
+using sdl::RWOpsDeleter;
+using sdl::RWOpsUniquePtr;
+using sdl::RWSeekWhence;
+using sdl::rw_from_file;
+
+using sdl::Point;
+using sdl::PointT;
+using sdl::point_dimension;
+using sdl::point_dimension_type;
+using sdl::select_point;
+using sdl::Rectangle;
+using sdl::RectangleT;
+using sdl::rectangle_dimension;
+using sdl::rectangle_dimension_type;
+using sdl::select_rectangle;
+using sdl::is_point_in_rectangle;
+
+using sdl::Color;
+using sdl::RendererConfig;
+using sdl::WindowConfig;
+using sdl::initialize;
+using sdl::quit;
+
+using sdl::RendererDeleter;
+using sdl::RendererUniquePtr;
+using sdl::SurfaceDeleter;
+using sdl::SurfaceUniquePtr;
+using sdl::TextureDeleter;
+using sdl::TextureUniquePtr;
+using sdl::WindowDeleter;
+using sdl::WindowUniquePtr;
+using sdl::make_renderer;
+using sdl::make_surface;
+using sdl::make_texture;
+using sdl::make_texture_from_native_surface;
+using sdl::make_texture_from_surface;
+using sdl::make_window;
+
+using sdl::convert_surface;
+using sdl::convert_surface_format;
+using sdl::convert_to_native_surface;
+using sdl::FormatConversion;
+using sdl::load_bmp;
+using sdl::NativeSurface;
+using sdl::save_bmp;
+using sdl::save_bmp_rw;
+using sdl::select_texture_format;
+using sdl::surface_has_alpha;
+
+using sdl::Renderer;
+using sdl::Texture;
+using sdl::Window;
+
+} // namespace sdl
+
+export namespace sdl::point_operators {
+using sdl::point_operators::operator==;
+using sdl::point_operators::operator!=;
+using sdl::point_operators::operator+;
+using sdl::point_operators::operator+=;
+using sdl::point_operators::operator-;
+using sdl::point_operators::operator-=;
+using sdl::point_operators::operator*;
+using sdl::point_operators::operator*=;
+using sdl::point_operators::operator/;
+using sdl::point_operators::operator/=;
+} // namespace sdl::point_operators
+
+export namespace sdl::rectangle_operators {
+using sdl::rectangle_operators::operator+;
+using sdl::rectangle_operators::operator+=;
+} // namespace sdl::rectangle_operators
+
+export namespace sdl::InitFlags {
+using sdl::InitFlags::audio;
+using sdl::InitFlags::events;
+using sdl::InitFlags::everything;
+using sdl::InitFlags::game_controller;
+using sdl::InitFlags::haptic;
+using sdl::InitFlags::joystick;
+using sdl::InitFlags::no_parachute;
+using sdl::InitFlags::none;
+using sdl::InitFlags::sensor;
+using sdl::InitFlags::timer;
+using sdl::InitFlags::video;
+} // namespace sdl::InitFlags
+
+// sdlpp_accounting.h
+export namespace sdl::accounting {
+using sdl::accounting::AllocationSite;
+using sdl::accounting::enabled;
+using sdl::accounting::estimate_bytes;
+using sdl::accounting::live_sites;
+using sdl::accounting::n_resource_types;
+using sdl::accounting::ResourceType;
+using sdl::accounting::ResourceUsage;
+using sdl::accounting::to_json;
+using sdl::accounting::to_string;
+using sdl::accounting::usage;
+#ifdef SDLWRAP_RESOURCE_ACCOUNTING
+using sdl::accounting::track;
+using sdl::accounting::untrack;
+#endif
+} // namespace sdl::accounting
+
+// sdlpp_audio.h
+export namespace sdl::audio {
+using sdl::audio::AudioDevice;
+using sdl::audio::load_wav;
+using sdl::audio::load_wav_rw;
+using sdl::audio::Mixer;
+using sdl::audio::MixerConfig;
+using sdl::audio::Sound;
+using sdl::audio::SoundId;
+using sdl::audio::SpscQueue;
+using sdl::audio::VoiceId;
+} // namespace sdl::audio
+
+export namespace sdl {
+
+// sdlpp_capture.h
+using sdl::CaptureConfig;
+using sdl::FrameCapturer;
+using sdl::SurfaceEncoder;
+using sdl::SurfacePool;
+
+// sdlpp_color_lut.h
+using sdl::ChannelCurves;
+using sdl::ColorLut3d;
+using sdl::ColorTransform;
+using sdl::set_palette;
+
+// sdlpp_draw_buffer.h
+using sdl::DrawCommandBuffer;
+using sdl::DrawState;
+
+// sdlpp_event_log.h
+using sdl::EventRecorder;
+using sdl::EventReplayer;
+using sdl::read_event_log;
+using sdl::RecordedEvent;
+using sdl::ReplayConfig;
+using sdl::ReplaySpeed;
+
+// sdlpp_font.h
+using sdl::BitmapFont;
+using sdl::decode_utf8;
+using sdl::FontDescriptor;
+using sdl::Glyph;
+using sdl::load_bitmap_font;
+using sdl::load_bmfont;
+using sdl::parse_bmfont;
+using sdl::TextLayout;
+
+// sdlpp_input.h
+using sdl::ButtonSet;
+using sdl::ControllerState;
+using sdl::GameControllerDeleter;
+using sdl::GameControllerUniquePtr;
+using sdl::InputFrame;
+using sdl::InputSnapshot;
+using sdl::InputTick;
+using sdl::InputTracker;
+using sdl::TripleBuffer;
+
+// sdlpp_mipmap.h
+using sdl::downscale_half;
+using sdl::MipmapConfig;
+using sdl::MipmappedImage;
+
+// sdlpp_particles.h
+using sdl::ParticleSpawn;
+using sdl::ParticleSystem;
+
+// sdlpp_recorder.h
+using sdl::convert_argb8888_to_i420;
+using sdl::FrameRecorder;
+using sdl::i420_frame_size;
+using sdl::RecorderConfig;
+using sdl::VideoContainer;
+
+// sdlpp_render_thread.h
+using sdl::CommandList;
+using sdl::FrameFence;
+using sdl::RenderCommand;
+using sdl::RenderThread;
+using sdl::TextureHandle;
+
+// sdlpp_tilemap.h
+using sdl::Tilemap;
+using sdl::TilemapConfig;
+using sdl::TileId;
+
+} // namespace sdl
+
+export namespace sdl::render_command {
+using sdl::render_command::Clear;
+using sdl::render_command::Copy;
+using sdl::render_command::CreateTexture;
+using sdl::render_command::CreateTextureFromSurface;
+using sdl::render_command::FillRectangles;
+using sdl::render_command::Invoke;
+using sdl::render_command::SetDrawBlendMode;
+using sdl::render_command::SetDrawColor;
+using sdl::render_command::SetRenderTarget;
+} // namespace sdl::render_command
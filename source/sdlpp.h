@@ -2,17 +2,17 @@
 
 #include <SDL.h>
 
-#include <gsl/gsl>
+#include "sdlpp_accounting.h"
 
-#include <chrono>
-#include <functional>
-#include <iostream>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <span>
 #include <stdexcept>
 #include <string>
-#include <thread>
+#include <type_traits>
+#include <utility>
 
 namespace sdl {
 
@@ -27,6 +27,7 @@ using EventType = SDL_EventType;
 using EventFilterCallback = int (*)(void* userdata, Event* event);
 
 void add_event_watch(EventFilterCallback callback, void* user_data) noexcept;
+void remove_event_watch(EventFilterCallback callback, void* user_data) noexcept;
 void set_event_filter(EventFilterCallback callback, void* user_data) noexcept;
 bool get_event_filter(EventFilterCallback* callback, void** user_data) noexcept;
 bool get_event_filter(EventFilterCallback& callback, void*& user_data) noexcept;
@@ -42,20 +43,25 @@ Event wait_event();
 void wait_event(Event* event, int timeout);
 void wait_event(Event& event, int timeout);
 Event wait_event(int timeout);
+// returns the first of `n_events` consecutive user event types
+Uint32 register_events(int n_events);
+// returns false if the event was filtered out
+bool push_event(Event& event);
 
 struct RWOpsDeleter
 {
     void operator()(SDL_RWops* rw_ops) noexcept
     {
+        SDLWRAP_UNTRACK(accounting::ResourceType::rw_ops, rw_ops);
         SDL_RWclose(rw_ops);
     }
 };
 using RWOpsUniquePtr = std::unique_ptr<SDL_RWops, RWOpsDeleter>;
 
-RWOpsUniquePtr rw_from_file(const char* filename, const char* mode);
-RWOpsUniquePtr rw_from_file(const std::string& filename, const std::string& mode);
+RWOpsUniquePtr rw_from_file(const char* filename, const char* mode SDLWRAP_SITE_PARAMETER);
+RWOpsUniquePtr rw_from_file(const std::string& filename, const std::string& mode SDLWRAP_SITE_PARAMETER);
 #ifdef HAVE_STDIO_H
-RWOpsUniquePtr rw_from_file(FILE* file);
+RWOpsUniquePtr rw_from_file(FILE* file SDLWRAP_SITE_PARAMETER);
 #endif
 
 enum class RWSeekWhence : int
@@ -69,10 +75,14 @@ class RWOps
 {
   public:
     RWOps(RWOpsUniquePtr rw_ops = nullptr) : rw_ops_{std::move(rw_ops)} {}
-    RWOps(const char* filename, const char* mode) : rw_ops_{rw_from_file(filename, mode)} {}
-    RWOps(const std::string& filename, const std::string& mode) : rw_ops_{rw_from_file(filename, mode)} {}
+    RWOps(const char* filename, const char* mode SDLWRAP_SITE_PARAMETER)
+        : rw_ops_{rw_from_file(filename, mode SDLWRAP_SITE_ARGUMENT)}
+    {}
+    RWOps(const std::string& filename, const std::string& mode SDLWRAP_SITE_PARAMETER)
+        : rw_ops_{rw_from_file(filename, mode SDLWRAP_SITE_ARGUMENT)}
+    {}
 #ifdef HAVE_STDIO_H
-    RWOps(FILE* file) : rw_ops_{rw_from_file(file)} {}
+    RWOps(FILE* file SDLWRAP_SITE_PARAMETER) : rw_ops_{rw_from_file(file SDLWRAP_SITE_ARGUMENT)} {}
 #endif
 
     [[nodiscard]] RWOpsUniquePtr::pointer get_pointer() const noexcept
@@ -82,6 +92,7 @@ class RWOps
 
     void close()
     {
+        SDLWRAP_UNTRACK(accounting::ResourceType::rw_ops, rw_ops_.get());
         SDL_RWclose(rw_ops_.release());
     }
 
@@ -103,6 +114,15 @@ class RWOps
         return seeked_offset;
     }
 
+    [[nodiscard]] std::int64_t size() const
+    {
+        std::int64_t size = SDL_RWsize(get_pointer());
+        if (size < 0) {
+            throw GenericError{};
+        }
+        return size;
+    }
+
     [[nodiscard]] std::int64_t tell() const
     {
         std::int64_t seeked_offset = SDL_RWtell(get_pointer());
@@ -316,17 +336,17 @@ struct WindowConfig
 };
 
 namespace InitFlags {
-static constexpr Uint32 none = 0;
-static constexpr Uint32 timer = SDL_INIT_TIMER;
-static constexpr Uint32 audio = SDL_INIT_AUDIO;
-static constexpr Uint32 video = SDL_INIT_VIDEO;
-static constexpr Uint32 joystick = SDL_INIT_JOYSTICK;
-static constexpr Uint32 haptic = SDL_INIT_HAPTIC;
-static constexpr Uint32 game_controller = SDL_INIT_GAMECONTROLLER;
-static constexpr Uint32 events = SDL_INIT_EVENTS;
-static constexpr Uint32 sensor = SDL_INIT_SENSOR;
-static constexpr Uint32 no_parachute = SDL_INIT_NOPARACHUTE;
-static constexpr Uint32 everything =
+inline constexpr Uint32 none = 0;
+inline constexpr Uint32 timer = SDL_INIT_TIMER;
+inline constexpr Uint32 audio = SDL_INIT_AUDIO;
+inline constexpr Uint32 video = SDL_INIT_VIDEO;
+inline constexpr Uint32 joystick = SDL_INIT_JOYSTICK;
+inline constexpr Uint32 haptic = SDL_INIT_HAPTIC;
+inline constexpr Uint32 game_controller = SDL_INIT_GAMECONTROLLER;
+inline constexpr Uint32 events = SDL_INIT_EVENTS;
+inline constexpr Uint32 sensor = SDL_INIT_SENSOR;
+inline constexpr Uint32 no_parachute = SDL_INIT_NOPARACHUTE;
+inline constexpr Uint32 everything =
     timer | audio | video | joystick | haptic | game_controller | events | sensor | no_parachute;
 } // namespace InitFlags
 
@@ -346,6 +366,7 @@ struct WindowDeleter
 {
     void operator()(SDL_Window* window) noexcept
     {
+        SDLWRAP_UNTRACK(accounting::ResourceType::window, window);
         SDL_DestroyWindow(window);
     }
 };
@@ -354,6 +375,7 @@ struct RendererDeleter
 {
     void operator()(SDL_Renderer* window) noexcept
     {
+        SDLWRAP_UNTRACK(accounting::ResourceType::renderer, window);
         SDL_DestroyRenderer(window);
     }
 };
@@ -362,6 +384,7 @@ struct TextureDeleter
 {
     void operator()(SDL_Texture* surface) noexcept
     {
+        SDLWRAP_UNTRACK(accounting::ResourceType::texture, surface);
         SDL_DestroyTexture(surface);
     }
 };
@@ -370,6 +393,7 @@ struct SurfaceDeleter
 {
     void operator()(SDL_Surface* surface) noexcept
     {
+        SDLWRAP_UNTRACK(accounting::ResourceType::surface, surface);
         SDL_FreeSurface(surface);
     }
 };
@@ -379,20 +403,63 @@ using RendererUniquePtr = std::unique_ptr<SDL_Renderer, RendererDeleter>;
 using TextureUniquePtr = std::unique_ptr<SDL_Texture, TextureDeleter>;
 using SurfaceUniquePtr = std::unique_ptr<SDL_Surface, SurfaceDeleter>;
 
-[[nodiscard]] WindowUniquePtr
-make_window(const char* title, int x_position, int y_position, int width, int height, Uint32 flags);
-[[nodiscard]] WindowUniquePtr make_window(const WindowConfig& config);
+[[nodiscard]] WindowUniquePtr make_window(
+    const char* title, int x_position, int y_position, int width, int height, Uint32 flags SDLWRAP_SITE_PARAMETER
+);
+[[nodiscard]] WindowUniquePtr make_window(const WindowConfig& config SDLWRAP_SITE_PARAMETER);
+
+[[nodiscard]] RendererUniquePtr make_renderer(SDL_Window* window, int index, Uint32 flags SDLWRAP_SITE_PARAMETER);
+[[nodiscard]] RendererUniquePtr make_renderer(SDL_Window* window, const RendererConfig& config SDLWRAP_SITE_PARAMETER);
 
-[[nodiscard]] RendererUniquePtr make_renderer(SDL_Window* window, int index, Uint32 flags);
-[[nodiscard]] RendererUniquePtr make_renderer(SDL_Window* window, const RendererConfig& config);
+[[nodiscard]] TextureUniquePtr
+make_texture(SDL_Renderer* renderer, Uint32 format, int access, int width, int height SDLWRAP_SITE_PARAMETER);
+[[nodiscard]] TextureUniquePtr
+make_texture_from_surface(SDL_Renderer* renderer, SDL_Surface* surface SDLWRAP_SITE_PARAMETER);
+// creates a static texture in the surface's own format and uploads the pixels unconverted
+[[nodiscard]] TextureUniquePtr
+make_texture_from_native_surface(SDL_Renderer* renderer, SDL_Surface* surface SDLWRAP_SITE_PARAMETER);
 
-[[nodiscard]] TextureUniquePtr make_texture(SDL_Renderer* renderer, Uint32 format, int access, int width, int height);
-[[nodiscard]] TextureUniquePtr make_texture_from_surface(SDL_Renderer* renderer, SDL_Surface* surface);
+[[nodiscard]] SurfaceUniquePtr make_surface(int width, int height, Uint32 format SDLWRAP_SITE_PARAMETER);
 
-[[nodiscard]] SurfaceUniquePtr load_bmp(const std::string& filename);
+[[nodiscard]] SurfaceUniquePtr load_bmp(const std::string& filename SDLWRAP_SITE_PARAMETER);
+void save_bmp_rw(SDL_Surface* surface, SDL_RWops* destination);
+void save_bmp(SDL_Surface* surface, const std::string& filename);
 
 [[nodiscard]] SurfaceUniquePtr
-convert_surface(SurfaceUniquePtr surface, const SDL_PixelFormat* format, Uint32 flags = 0);
+convert_surface(SurfaceUniquePtr surface, const SDL_PixelFormat* format, Uint32 flags = 0 SDLWRAP_SITE_PARAMETER);
+// converts to a pixel format enum; named apart from convert_surface so that 0 or NULL as the format is not ambiguous
+[[nodiscard]] SurfaceUniquePtr
+convert_surface_format(SurfaceUniquePtr surface, Uint32 format, Uint32 flags = 0 SDLWRAP_SITE_PARAMETER);
+
+[[nodiscard]] bool surface_has_alpha(const SDL_Surface& surface) noexcept;
+
+// Picks the texture format a renderer should store `surface_format` pixels in: the surface's own format when the
+// renderer supports it natively, otherwise the renderer's most preferred packed format that keeps alpha if needed.
+[[nodiscard]] Uint32 select_texture_format(const SDL_RendererInfo& info, Uint32 surface_format, bool needs_alpha);
+
+struct FormatConversion
+{
+    Uint32 source_format;
+    Uint32 texture_format;
+    // set whenever the pixels were copied into a new surface, which also happens without a format change, e.g. to turn
+    // a color key into alpha
+    bool pixels_converted;
+
+    [[nodiscard]] bool converted() const noexcept
+    {
+        return pixels_converted;
+    }
+};
+
+// a surface already in a format the renderer stores natively, plus the conversion it took to get there
+struct NativeSurface
+{
+    SurfaceUniquePtr surface;
+    FormatConversion conversion;
+};
+
+[[nodiscard]] NativeSurface
+convert_to_native_surface(SurfaceUniquePtr surface, const SDL_RendererInfo& info SDLWRAP_SITE_PARAMETER);
 
 class Texture
 {
@@ -418,6 +485,11 @@ class Texture
         return texture_.get();
     }
 
+    [[nodiscard]] TextureUniquePtr release() noexcept
+    {
+        return std::move(texture_);
+    }
+
     [[nodiscard]] Uint32 format() const noexcept
     {
         Uint32 format;
@@ -460,6 +532,13 @@ class Texture
         return size;
     }
 
+    void update(const Rectangle<int>* rectangle, const void* pixels, int pitch) const
+    {
+        if (SDL_UpdateTexture(get_pointer(), rectangle, pixels, pitch) != 0) {
+            throw GenericError{};
+        }
+    }
+
     operator SDL_Texture&() const noexcept
     {
         return *get_pointer();
@@ -473,8 +552,12 @@ class Renderer
 {
   public:
     Renderer(RendererUniquePtr renderer = nullptr) : renderer_{std::move(renderer)} {}
-    Renderer(SDL_Window* window, int index, Uint32 flags) : renderer_{make_renderer(window, index, flags)} {}
-    Renderer(SDL_Window* window, const RendererConfig& config) : renderer_{make_renderer(window, config)} {}
+    Renderer(SDL_Window* window, int index, Uint32 flags SDLWRAP_SITE_PARAMETER)
+        : renderer_{make_renderer(window, index, flags SDLWRAP_SITE_ARGUMENT)}
+    {}
+    Renderer(SDL_Window* window, const RendererConfig& config SDLWRAP_SITE_PARAMETER)
+        : renderer_{make_renderer(window, config SDLWRAP_SITE_ARGUMENT)}
+    {}
 
     [[nodiscard]] RendererUniquePtr::pointer get_pointer() const noexcept
     {
@@ -518,6 +601,25 @@ class Renderer
         return rectangle;
     }
 
+    // `rectangle` null disables clipping
+    void set_clip_rectangle(const sdl::Rectangle<int>* rectangle) const
+    {
+        if (SDL_RenderSetClipRect(get_pointer(), rectangle) != 0) {
+            throw GenericError{};
+        }
+    }
+
+    // empty when clipping is disabled
+    [[nodiscard]] std::optional<sdl::Rectangle<int>> get_clip_rectangle() const
+    {
+        if (SDL_RenderIsClipEnabled(get_pointer()) != SDL_TRUE) {
+            return std::nullopt;
+        }
+        sdl::Rectangle<int> rectangle;
+        SDL_RenderGetClipRect(get_pointer(), &rectangle);
+        return rectangle;
+    }
+
     void set_render_target(SDL_Texture* texture) const
     {
         if (SDL_SetRenderTarget(get_pointer(), texture) != 0) {
@@ -530,6 +632,38 @@ class Renderer
         return SDL_GetRenderTarget(get_pointer());
     }
 
+    [[nodiscard]] SDL_RendererInfo info() const
+    {
+        SDL_RendererInfo info;
+        if (SDL_GetRendererInfo(get_pointer(), &info) != 0) {
+            throw GenericError{};
+        }
+        return info;
+    }
+
+    [[nodiscard]] Point<int> output_size() const
+    {
+        Point<int> size;
+        if (SDL_GetRendererOutputSize(get_pointer(), &size.x, &size.y) != 0) {
+            throw GenericError{};
+        }
+        return size;
+    }
+
+    // reads back `rectangle` of the current render target, or all of it when `rectangle` is null
+    void read_pixels(const Rectangle<int>* rectangle, Uint32 format, void* pixels, int pitch) const
+    {
+        if (SDL_RenderReadPixels(get_pointer(), rectangle, format, pixels, pitch) != 0) {
+            throw GenericError{};
+        }
+    }
+
+    // reads back the current render target into `surface`, which must be at least as large as the target
+    void read_pixels(SDL_Surface& surface) const
+    {
+        read_pixels(nullptr, surface.format->format, surface.pixels, surface.pitch);
+    }
+
     void set_draw_color(const Color& color) const
     {
         if (SDL_SetRenderDrawColor(get_pointer(), color.r, color.g, color.b, color.a) != 0) {
@@ -537,6 +671,15 @@ class Renderer
         }
     }
 
+    [[nodiscard]] Color get_draw_color() const
+    {
+        Color color;
+        if (SDL_GetRenderDrawColor(get_pointer(), &color.r, &color.g, &color.b, &color.a) != 0) {
+            throw GenericError{};
+        }
+        return color;
+    }
+
     void clear() const
     {
         if (SDL_RenderClear(get_pointer()) != 0) {
@@ -553,21 +696,52 @@ class Renderer
     void draw_point(T point_x, T point_y) const;
     template <PointT Point>
     void draw_point(Point point) const;
+    void draw_points(std::span<const Point<int>> points) const;
+    void draw_points(std::span<const Point<float>> points) const;
 
     void draw_line(int x_begin, int y_begin, int x_end, int y_end) const;
     void draw_line(Point<int> begin, Point<int> end) const;
+    // subpixel lines; named apart from draw_line so calls with double or braced arguments stay unambiguous
+    void draw_line_f(float x_begin, float y_begin, float x_end, float y_end) const;
+    void draw_line_f(Point<float> begin, Point<float> end) const;
+    // draws a connected polyline through `points`
+    void draw_lines(std::span<const Point<int>> points) const;
+    void draw_lines(std::span<const Point<float>> points) const;
+
+    template <RectangleT Rectangle>
+    void draw_rectangle(const Rectangle& rectangle) const;
+    void draw_rectangles(std::span<const Rectangle<int>> rectangles) const;
+    void draw_rectangles(std::span<const Rectangle<float>> rectangles) const;
 
     template <RectangleT Rectangle>
     void fill_rectangle(const Rectangle& rectangle);
     template <RectangleT Rectangle>
     void fill_rectangles(std::span<Rectangle> rectangles);
+    void fill_rectangles(std::span<const Rectangle<int>> rectangles) const;
+    void fill_rectangles(std::span<const Rectangle<float>> rectangles) const;
 
     template <RectangleT DestinationRectangle>
     void copy(SDL_Texture& texture, const Rectangle<int>& source, const DestinationRectangle& destination);
 
-    [[nodiscard]] TextureUniquePtr make_texture(Uint32 format, int access, int width, int height) const;
-    [[nodiscard]] TextureUniquePtr make_texture(const Texture::Properties& properties) const;
-    [[nodiscard]] TextureUniquePtr make_texture_from_surface(SDL_Surface* surface) const;
+    // draws triangles, indexed by `indices` or taken three vertices at a time when `indices` is empty
+    void render_geometry(
+        SDL_Texture* texture, std::span<const SDL_Vertex> vertices, std::span<const int> indices = {}
+    ) const;
+    // as render_geometry with tightly packed, separate position (x, y pairs), color and texture coordinate (u, v
+    // pairs) arrays; `texture_coordinates` may be empty when `texture` is null
+    void render_geometry(
+        SDL_Texture* texture,
+        std::span<const float> positions,
+        std::span<const Color> colors,
+        std::span<const float> texture_coordinates,
+        std::span<const int> indices = {}
+    ) const;
+
+    [[nodiscard]] TextureUniquePtr
+    make_texture(Uint32 format, int access, int width, int height SDLWRAP_SITE_PARAMETER) const;
+    [[nodiscard]] TextureUniquePtr make_texture(const Texture::Properties& properties SDLWRAP_SITE_PARAMETER) const;
+    [[nodiscard]] TextureUniquePtr make_texture_from_surface(SDL_Surface* surface SDLWRAP_SITE_PARAMETER) const;
+    [[nodiscard]] TextureUniquePtr make_texture_from_native_surface(SDL_Surface* surface SDLWRAP_SITE_PARAMETER) const;
 
   private:
     RendererUniquePtr renderer_;
@@ -577,11 +751,13 @@ class Window
 {
   public:
     Window(WindowUniquePtr window = nullptr) : window_(std::move(window)) {}
-    Window(const char* title, int x_position, int y_position, int width, int height, Uint32 flags)
-        : Window(make_window(title, x_position, y_position, width, height, flags))
+    Window(
+        const char* title, int x_position, int y_position, int width, int height, Uint32 flags SDLWRAP_SITE_PARAMETER
+    )
+        : Window(make_window(title, x_position, y_position, width, height, flags SDLWRAP_SITE_ARGUMENT))
     {}
-    Window(const WindowConfig& config)
-        : Window(config.title, config.x_position, config.y_position, config.width, config.height, config.flags)
+    Window(const WindowConfig& config SDLWRAP_SITE_PARAMETER)
+        : Window(make_window(config SDLWRAP_SITE_ARGUMENT))
     {}
 
     [[nodiscard]] WindowUniquePtr::pointer get_pointer() const noexcept
@@ -0,0 +1,265 @@
+#include "sdlpp_accounting.h"
+
+#include <algorithm>
+#include <compare>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+
+namespace sdl::accounting {
+
+namespace {
+
+struct SiteKey
+{
+    ResourceType type;
+    // source_location strings have static storage duration
+    std::string_view file;
+    std::uint_least32_t line;
+    std::uint_least32_t column;
+    std::string_view function;
+
+    auto operator<=>(const SiteKey&) const = default;
+};
+
+struct SiteUsage
+{
+    std::size_t live = 0;
+    std::size_t bytes = 0;
+};
+
+struct Allocation
+{
+    ResourceType type;
+    std::size_t bytes;
+    SiteUsage* site;
+};
+
+class Registry
+{
+  public:
+#ifdef SDLWRAP_RESOURCE_ACCOUNTING
+    void track(ResourceType type, const void* resource, std::size_t bytes, const std::source_location& site)
+    {
+        const std::scoped_lock lock{mutex_};
+        // a pointer freed behind our back may have been handed out again
+        remove(resource);
+
+        const SiteKey key{type, site.file_name(), site.line(), site.column(), site.function_name()};
+        SiteUsage& site_usage = sites_[key];
+        site_usage.live += 1;
+        site_usage.bytes += bytes;
+        allocations_.emplace(resource, Allocation{type, bytes, &site_usage});
+
+        ResourceUsage& resource_usage = usage_[static_cast<std::size_t>(type)];
+        resource_usage.live += 1;
+        resource_usage.bytes += bytes;
+        resource_usage.n_created += 1;
+        resource_usage.peak_live = std::max(resource_usage.peak_live, resource_usage.live);
+        resource_usage.peak_bytes = std::max(resource_usage.peak_bytes, resource_usage.bytes);
+    }
+
+    void untrack(ResourceType type, const void* resource) noexcept
+    {
+        const std::scoped_lock lock{mutex_};
+        const auto found = allocations_.find(resource);
+        if (found != allocations_.end() && found->second.type == type) {
+            remove(resource);
+        }
+    }
+#endif
+
+    [[nodiscard]] std::array<ResourceUsage, n_resource_types> usage()
+    {
+        const std::scoped_lock lock{mutex_};
+        return usage_;
+    }
+
+    [[nodiscard]] std::vector<AllocationSite> live_sites()
+    {
+        std::vector<AllocationSite> result;
+        {
+            const std::scoped_lock lock{mutex_};
+            for (const auto& [key, site] : sites_) {
+                if (site.live != 0) {
+                    result.push_back(AllocationSite{
+                        key.type, std::string{key.file}, key.line, std::string{key.function}, site.live, site.bytes
+                    });
+                }
+            }
+        }
+        std::sort(result.begin(), result.end(), [](const AllocationSite& lhs, const AllocationSite& rhs) {
+            return std::tie(rhs.bytes, rhs.live) < std::tie(lhs.bytes, lhs.live);
+        });
+        return result;
+    }
+
+  private:
+    void remove(const void* resource) noexcept
+    {
+        const auto found = allocations_.find(resource);
+        if (found == allocations_.end()) {
+            return;
+        }
+        const Allocation& allocation = found->second;
+        allocation.site->live -= 1;
+        allocation.site->bytes -= allocation.bytes;
+        ResourceUsage& resource_usage = usage_[static_cast<std::size_t>(allocation.type)];
+        resource_usage.live -= 1;
+        resource_usage.bytes -= allocation.bytes;
+        allocations_.erase(found);
+    }
+
+    std::mutex mutex_;
+    std::array<ResourceUsage, n_resource_types> usage_{};
+    std::unordered_map<const void*, Allocation> allocations_;
+    // map nodes are stable, so allocations can point at their site
+    std::map<SiteKey, SiteUsage> sites_;
+};
+
+Registry& registry()
+{
+    // never destroyed, so resources held by static objects can still be released during exit
+    static Registry* const instance = new Registry;
+    return *instance;
+}
+
+void append_json_string(std::string& json, std::string_view value)
+{
+    json += '"';
+    for (const char character : value) {
+        if (character == '"' || character == '\\') {
+            json += '\\';
+            json += character;
+        } else if (static_cast<unsigned char>(character) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned int>(character));
+            json += escaped;
+        } else {
+            json += character;
+        }
+    }
+    json += '"';
+}
+
+} // namespace
+
+const char* to_string(ResourceType type) noexcept
+{
+    switch (type) {
+    case ResourceType::window:
+        return "window";
+    case ResourceType::renderer:
+        return "renderer";
+    case ResourceType::texture:
+        return "texture";
+    case ResourceType::surface:
+        return "surface";
+    case ResourceType::rw_ops:
+        return "rw_ops";
+    }
+    return "unknown";
+}
+
+std::size_t estimate_bytes(Uint32 format, int width, int height) noexcept
+{
+    const auto n_pixels = static_cast<std::size_t>(std::max(width, 0)) * static_cast<std::size_t>(std::max(height, 0));
+    if (SDL_ISPIXELFORMAT_FOURCC(format)) {
+        // planar 4:2:0 formats store 12 bits per pixel, packed 4:2:2 formats 16
+        const bool is_420 = format == SDL_PIXELFORMAT_IYUV || format == SDL_PIXELFORMAT_YV12 ||
+                            format == SDL_PIXELFORMAT_NV12 || format == SDL_PIXELFORMAT_NV21;
+        return is_420 ? n_pixels * 3 / 2 : n_pixels * 2;
+    }
+    return n_pixels * SDL_BYTESPERPIXEL(format);
+}
+
+std::size_t estimate_bytes(const SDL_Surface* surface) noexcept
+{
+    return static_cast<std::size_t>(surface->pitch) * static_cast<std::size_t>(surface->h);
+}
+
+std::size_t estimate_bytes(SDL_Texture* texture) noexcept
+{
+    Uint32 format = 0;
+    int width = 0;
+    int height = 0;
+    if (SDL_QueryTexture(texture, &format, nullptr, &width, &height) != 0) {
+        return 0;
+    }
+    return estimate_bytes(format, width, height);
+}
+
+ResourceUsage usage(ResourceType type)
+{
+    return usage()[static_cast<std::size_t>(type)];
+}
+
+std::array<ResourceUsage, n_resource_types> usage()
+{
+    return registry().usage();
+}
+
+std::vector<AllocationSite> live_sites()
+{
+    return registry().live_sites();
+}
+
+std::string to_json()
+{
+    const std::array<ResourceUsage, n_resource_types> totals = usage();
+    std::string json = "{\"enabled\":";
+    json += enabled ? "true" : "false";
+    json += ",\"resources\":{";
+    for (std::size_t i = 0; i < n_resource_types; ++i) {
+        const ResourceUsage& resource_usage = totals[i];
+        if (i != 0) {
+            json += ',';
+        }
+        append_json_string(json, to_string(static_cast<ResourceType>(i)));
+        json += ":{\"live\":" + std::to_string(resource_usage.live);
+        json += ",\"peak_live\":" + std::to_string(resource_usage.peak_live);
+        json += ",\"bytes\":" + std::to_string(resource_usage.bytes);
+        json += ",\"peak_bytes\":" + std::to_string(resource_usage.peak_bytes);
+        json += ",\"created\":" + std::to_string(resource_usage.n_created) + '}';
+    }
+    json += "},\"sites\":[";
+    bool first = true;
+    for (const AllocationSite& site : live_sites()) {
+        if (!first) {
+            json += ',';
+        }
+        first = false;
+        json += "{\"type\":";
+        append_json_string(json, to_string(site.type));
+        json += ",\"file\":";
+        append_json_string(json, site.file);
+        json += ",\"line\":" + std::to_string(site.line);
+        json += ",\"function\":";
+        append_json_string(json, site.function);
+        json += ",\"live\":" + std::to_string(site.live);
+        json += ",\"bytes\":" + std::to_string(site.bytes) + '}';
+    }
+    json += "]}";
+    return json;
+}
+
+#ifdef SDLWRAP_RESOURCE_ACCOUNTING
+void track(ResourceType type, const void* resource, std::size_t bytes, const std::source_location& site) noexcept
+{
+    try {
+        registry().track(type, resource, bytes, site);
+    } catch (...) {
+        // accounting must never turn a successful allocation into a failure
+    }
+}
+
+void untrack(ResourceType type, const void* resource) noexcept
+{
+    registry().untrack(type, resource);
+}
+#endif
+
+} // namespace sdl::accounting
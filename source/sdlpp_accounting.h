@@ -0,0 +1,91 @@
+#pragma once
+
+#include <SDL.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifdef SDLWRAP_RESOURCE_ACCOUNTING
+#include <source_location>
+#endif
+
+// Resource accounting is compiled in only when SDLWRAP_RESOURCE_ACCOUNTING is defined, which the CMake option of the
+// same name does for every target linking Core. The make_* factories then take a defaulted std::source_location to
+// record their caller, and the deleters report each release. Without it these macros expand to nothing, so the
+// factories and deleters are exactly the plain SDL calls.
+#ifdef SDLWRAP_RESOURCE_ACCOUNTING
+#define SDLWRAP_SITE_PARAMETER , std::source_location site = std::source_location::current()
+#define SDLWRAP_SITE_DEFINITION , std::source_location site
+#define SDLWRAP_SITE_ARGUMENT , site
+#define SDLWRAP_TRACK(type, resource, bytes) ::sdl::accounting::track(type, resource, bytes, site)
+#define SDLWRAP_UNTRACK(type, resource) ::sdl::accounting::untrack(type, resource)
+#else
+#define SDLWRAP_SITE_PARAMETER
+#define SDLWRAP_SITE_DEFINITION
+#define SDLWRAP_SITE_ARGUMENT
+#define SDLWRAP_TRACK(type, resource, bytes) static_cast<void>(0)
+#define SDLWRAP_UNTRACK(type, resource) static_cast<void>(0)
+#endif
+
+namespace sdl::accounting {
+
+#ifdef SDLWRAP_RESOURCE_ACCOUNTING
+inline constexpr bool enabled = true;
+#else
+inline constexpr bool enabled = false;
+#endif
+
+enum class ResourceType : std::uint8_t
+{
+    window,
+    renderer,
+    texture,
+    surface,
+    rw_ops,
+};
+
+inline constexpr std::size_t n_resource_types = 5;
+
+[[nodiscard]] const char* to_string(ResourceType type) noexcept;
+
+struct ResourceUsage
+{
+    std::size_t live = 0;
+    std::size_t peak_live = 0;
+    // estimated from pixel format and dimensions; zero for windows, renderers and RWops
+    std::size_t bytes = 0;
+    std::size_t peak_bytes = 0;
+    std::size_t n_created = 0;
+};
+
+// live resources created from one source location
+struct AllocationSite
+{
+    ResourceType type;
+    std::string file;
+    std::uint_least32_t line;
+    std::string function;
+    std::size_t live;
+    std::size_t bytes;
+};
+
+[[nodiscard]] std::size_t estimate_bytes(Uint32 format, int width, int height) noexcept;
+[[nodiscard]] std::size_t estimate_bytes(const SDL_Surface* surface) noexcept;
+[[nodiscard]] std::size_t estimate_bytes(SDL_Texture* texture) noexcept;
+
+// The queries are always available; without SDLWRAP_RESOURCE_ACCOUNTING they report nothing.
+[[nodiscard]] ResourceUsage usage(ResourceType type);
+[[nodiscard]] std::array<ResourceUsage, n_resource_types> usage();
+// sorted by descending bytes, then descending live count
+[[nodiscard]] std::vector<AllocationSite> live_sites();
+[[nodiscard]] std::string to_json();
+
+#ifdef SDLWRAP_RESOURCE_ACCOUNTING
+void track(ResourceType type, const void* resource, std::size_t bytes, const std::source_location& site) noexcept;
+void untrack(ResourceType type, const void* resource) noexcept;
+#endif
+
+} // namespace sdl::accounting
@@ -0,0 +1,279 @@
+#include "sdlpp_audio.h"
+
+#include "sdlpp.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <numbers>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SDLWRAP_HAVE_SSE2 1
+#endif
+
+namespace sdl::audio {
+
+namespace {
+
+struct WavDeleter
+{
+    void operator()(Uint8* buffer) noexcept
+    {
+        SDL_FreeWAV(buffer);
+    }
+};
+
+struct AudioStreamDeleter
+{
+    void operator()(SDL_AudioStream* stream) noexcept
+    {
+        SDL_FreeAudioStream(stream);
+    }
+};
+
+// adds interleaved stereo `input` scaled by per-channel gains to `output`
+void mix_frames(float* output, const float* input, std::size_t n_frames, float gain_left, float gain_right) noexcept
+{
+    const std::size_t n_samples = 2 * n_frames;
+    std::size_t i = 0;
+#ifdef SDLWRAP_HAVE_SSE2
+    const __m128 gains = _mm_setr_ps(gain_left, gain_right, gain_left, gain_right);
+    for (; i + 4 <= n_samples; i += 4) {
+        const __m128 mixed = _mm_add_ps(_mm_loadu_ps(output + i), _mm_mul_ps(_mm_loadu_ps(input + i), gains));
+        _mm_storeu_ps(output + i, mixed);
+    }
+#endif
+    for (; i < n_samples; i += 2) {
+        output[i] += input[i] * gain_left;
+        output[i + 1] += input[i + 1] * gain_right;
+    }
+}
+
+void apply_master_gain(float* output, std::size_t n_samples, float gain) noexcept
+{
+    std::size_t i = 0;
+#ifdef SDLWRAP_HAVE_SSE2
+    const __m128 gains = _mm_set1_ps(gain);
+    const __m128 minimum = _mm_set1_ps(-1.0F);
+    const __m128 maximum = _mm_set1_ps(1.0F);
+    for (; i + 4 <= n_samples; i += 4) {
+        const __m128 scaled = _mm_mul_ps(_mm_loadu_ps(output + i), gains);
+        _mm_storeu_ps(output + i, _mm_min_ps(_mm_max_ps(scaled, minimum), maximum));
+    }
+#endif
+    for (; i < n_samples; ++i) {
+        output[i] = std::clamp(output[i] * gain, -1.0F, 1.0F);
+    }
+}
+
+// constant-power pan law
+std::pair<float, float> channel_gains(float gain, float pan) noexcept
+{
+    const float angle = (std::clamp(pan, -1.0F, 1.0F) + 1.0F) * std::numbers::pi_v<float> / 4.0F;
+    return {gain * std::cos(angle), gain * std::sin(angle)};
+}
+
+} // namespace
+
+AudioDevice::AudioDevice(const char* device, const SDL_AudioSpec& desired)
+    : device_{SDL_OpenAudioDevice(device, 0, &desired, &spec_, 0)}
+{
+    if (device_ == 0) {
+        throw GenericError{};
+    }
+}
+
+AudioDevice::AudioDevice(AudioDevice&& other) noexcept
+    : spec_{other.spec_}, device_{std::exchange(other.device_, 0)}
+{}
+
+AudioDevice& AudioDevice::operator=(AudioDevice&& other) noexcept
+{
+    if (this != &other) {
+        close();
+        device_ = std::exchange(other.device_, 0);
+        spec_ = other.spec_;
+    }
+    return *this;
+}
+
+AudioDevice::~AudioDevice()
+{
+    close();
+}
+
+void AudioDevice::close() noexcept
+{
+    if (device_ != 0) {
+        SDL_CloseAudioDevice(std::exchange(device_, 0));
+    }
+}
+
+Sound load_wav_rw(SDL_RWops* source, int frequency)
+{
+    SDL_AudioSpec spec;
+    Uint8* buffer = nullptr;
+    Uint32 length = 0;
+    if (SDL_LoadWAV_RW(source, 0, &spec, &buffer, &length) == nullptr) {
+        throw GenericError{};
+    }
+    const std::unique_ptr<Uint8, WavDeleter> wav{buffer};
+
+    const std::unique_ptr<SDL_AudioStream, AudioStreamDeleter> stream{
+        SDL_NewAudioStream(spec.format, spec.channels, spec.freq, AUDIO_F32SYS, 2, frequency)
+    };
+    if (stream == nullptr || SDL_AudioStreamPut(stream.get(), wav.get(), static_cast<int>(length)) != 0 ||
+        SDL_AudioStreamFlush(stream.get()) != 0) {
+        throw GenericError{};
+    }
+
+    Sound sound;
+    sound.samples.resize(static_cast<std::size_t>(SDL_AudioStreamAvailable(stream.get())) / sizeof(float));
+    const int n_bytes = static_cast<int>(sound.samples.size() * sizeof(float));
+    if (SDL_AudioStreamGet(stream.get(), sound.samples.data(), n_bytes) < 0) {
+        throw GenericError{};
+    }
+    return sound;
+}
+
+Sound load_wav(const std::string& filename, int frequency)
+{
+    return load_wav_rw(rw_from_file(filename, "rb").get(), frequency);
+}
+
+Mixer::Mixer(const MixerConfig& config) : frequency_{config.frequency}
+{
+    voices_.reserve(config.max_voices);
+
+    SDL_AudioSpec desired{};
+    desired.freq = config.frequency;
+    desired.format = AUDIO_F32SYS;
+    desired.channels = 2;
+    desired.samples = config.samples;
+    desired.callback = &Mixer::callback;
+    desired.userdata = this;
+    device_ = AudioDevice{config.device, desired};
+    device_.pause(false);
+}
+
+Mixer::~Mixer()
+{
+    device_.close();
+}
+
+SoundId Mixer::add_sound(Sound sound)
+{
+    sounds_.push_back(std::move(sound));
+    return static_cast<SoundId>(sounds_.size() - 1);
+}
+
+SoundId Mixer::load_wav(const std::string& filename)
+{
+    return add_sound(::sdl::audio::load_wav(filename, frequency_));
+}
+
+std::optional<VoiceId> Mixer::play(SoundId sound, float gain, float pan, bool loop)
+{
+    const auto [gain_left, gain_right] = channel_gains(gain, pan);
+    const VoiceId voice = next_voice_++;
+    if (!commands_.push(Command{CommandType::play, loop, voice, &sounds_.at(sound), gain_left, gain_right})) {
+        return std::nullopt;
+    }
+    return voice;
+}
+
+bool Mixer::stop(VoiceId voice)
+{
+    return commands_.push(Command{CommandType::stop, false, voice, nullptr, 0.0F, 0.0F});
+}
+
+bool Mixer::set_gain(VoiceId voice, float gain, float pan)
+{
+    const auto [gain_left, gain_right] = channel_gains(gain, pan);
+    return commands_.push(Command{CommandType::set_gain, false, voice, nullptr, gain_left, gain_right});
+}
+
+bool Mixer::stop_all()
+{
+    return commands_.push(Command{CommandType::stop_all, false, 0, nullptr, 0.0F, 0.0F});
+}
+
+bool Mixer::set_master_gain(float gain)
+{
+    return commands_.push(Command{CommandType::set_master_gain, false, 0, nullptr, gain, gain});
+}
+
+void Mixer::callback(void* user_data, Uint8* stream, int length) noexcept
+{
+    auto* const mixer = static_cast<Mixer*>(user_data);
+    const std::size_t n_frames = static_cast<std::size_t>(length) / (2 * sizeof(float));
+    mixer->mix(reinterpret_cast<float*>(stream), n_frames);
+}
+
+void Mixer::mix(float* output, std::size_t n_frames) noexcept
+{
+    while (const std::optional<Command> command = commands_.pop()) {
+        apply(*command);
+    }
+
+    std::memset(output, 0, 2 * n_frames * sizeof(float));
+    for (Voice& voice : voices_) {
+        const std::size_t length = voice.sound->n_frames();
+        std::size_t mixed = 0;
+        while (mixed < n_frames && voice.position < length) {
+            const std::size_t n = std::min(n_frames - mixed, length - voice.position);
+            mix_frames(
+                output + 2 * mixed, voice.sound->samples.data() + 2 * voice.position, n, voice.gain_left,
+                voice.gain_right
+            );
+            mixed += n;
+            voice.position += n;
+            if (voice.loop && voice.position == length) {
+                voice.position = 0;
+            }
+        }
+    }
+    std::erase_if(voices_, [](const Voice& voice) { return voice.position >= voice.sound->n_frames(); });
+
+    apply_master_gain(output, 2 * n_frames, master_gain_);
+}
+
+void Mixer::apply(const Command& command) noexcept
+{
+    const auto find_voice = [this](VoiceId id) {
+        return std::find_if(voices_.begin(), voices_.end(), [id](const Voice& voice) { return voice.id == id; });
+    };
+
+    switch (command.type) {
+    case CommandType::play:
+        // voices_ never grows past the capacity reserved up front, so the callback never allocates
+        if (voices_.size() < voices_.capacity() && command.sound->n_frames() != 0) {
+            voices_.push_back(
+                Voice{command.voice, command.sound, 0, command.gain_left, command.gain_right, command.loop}
+            );
+        }
+        break;
+    case CommandType::stop:
+        if (const auto voice = find_voice(command.voice); voice != voices_.end()) {
+            voices_.erase(voice);
+        }
+        break;
+    case CommandType::set_gain:
+        if (const auto voice = find_voice(command.voice); voice != voices_.end()) {
+            voice->gain_left = command.gain_left;
+            voice->gain_right = command.gain_right;
+        }
+        break;
+    case CommandType::stop_all:
+        voices_.clear();
+        break;
+    case CommandType::set_master_gain:
+        master_gain_ = command.gain_left;
+        break;
+    }
+}
+
+} // namespace sdl::audio
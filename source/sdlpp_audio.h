@@ -0,0 +1,191 @@
+#pragma once
+
+#include "sdlpp.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace sdl::audio {
+
+// Bounded single-producer single-consumer ring buffer. push and pop never block or allocate, so one side may run in
+// an audio callback. Holds at most Capacity - 1 elements.
+template <typename T, std::size_t Capacity>
+class SpscQueue
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+  public:
+    // producer side; returns false when full
+    bool push(const T& value) noexcept
+    {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        const std::size_t next = (tail + 1) & (Capacity - 1);
+        if (next == head_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        slots_[tail] = value;
+        tail_.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // consumer side
+    std::optional<T> pop() noexcept
+    {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return std::nullopt;
+        }
+        T value = slots_[head];
+        head_.store((head + 1) & (Capacity - 1), std::memory_order_release);
+        return value;
+    }
+
+  private:
+    std::array<T, Capacity> slots_{};
+    alignas(64) std::atomic<std::size_t> head_{0};
+    alignas(64) std::atomic<std::size_t> tail_{0};
+};
+
+class AudioDevice
+{
+  public:
+    AudioDevice() noexcept = default;
+    // opens the named device, or the default one when `device` is null; SDL converts from `desired` if the hardware
+    // needs another format
+    AudioDevice(const char* device, const SDL_AudioSpec& desired);
+    AudioDevice(const AudioDevice&) = delete;
+    AudioDevice& operator=(const AudioDevice&) = delete;
+    AudioDevice(AudioDevice&& other) noexcept;
+    AudioDevice& operator=(AudioDevice&& other) noexcept;
+    ~AudioDevice();
+
+    [[nodiscard]] SDL_AudioDeviceID get_id() const noexcept
+    {
+        return device_;
+    }
+
+    [[nodiscard]] const SDL_AudioSpec& spec() const noexcept
+    {
+        return spec_;
+    }
+
+    void pause(bool paused) const noexcept
+    {
+        SDL_PauseAudioDevice(device_, paused ? 1 : 0);
+    }
+
+    void close() noexcept;
+
+  private:
+    // spec_ is declared first because opening the device fills it in
+    SDL_AudioSpec spec_{};
+    SDL_AudioDeviceID device_{0};
+};
+
+// Interleaved stereo float samples at the mixer's sample rate.
+struct Sound
+{
+    std::vector<float> samples;
+
+    [[nodiscard]] std::size_t n_frames() const noexcept
+    {
+        return samples.size() / 2;
+    }
+};
+
+// decodes a WAV file and converts it once to interleaved stereo float at `frequency`
+[[nodiscard]] Sound load_wav_rw(SDL_RWops* source, int frequency);
+[[nodiscard]] Sound load_wav(const std::string& filename, int frequency);
+
+using SoundId = std::uint32_t;
+using VoiceId = std::uint32_t;
+
+struct MixerConfig
+{
+    // null selects the default device; set SDL_AUDIODRIVER=dummy or disk to run without audio hardware
+    const char* device = nullptr;
+    int frequency = 48000;
+    Uint16 samples = 512;
+    std::size_t max_voices = 64;
+};
+
+// Mixes many voices in the audio callback. Control calls from the game thread are posted to the callback through a
+// lock-free queue, so neither side ever waits for the other. All control calls must come from a single thread.
+class Mixer
+{
+  public:
+    Mixer(const MixerConfig& config = {});
+    Mixer(const Mixer&) = delete;
+    Mixer& operator=(const Mixer&) = delete;
+    ~Mixer();
+
+    // the sound is owned by the mixer and stays valid for its lifetime
+    SoundId add_sound(Sound sound);
+    SoundId load_wav(const std::string& filename);
+
+    // `pan` ranges from -1 (left) to 1 (right); returns nullopt if the command queue is full
+    std::optional<VoiceId> play(SoundId sound, float gain = 1.0F, float pan = 0.0F, bool loop = false);
+    bool stop(VoiceId voice);
+    bool set_gain(VoiceId voice, float gain, float pan = 0.0F);
+    bool stop_all();
+    bool set_master_gain(float gain);
+
+    [[nodiscard]] const AudioDevice& device() const noexcept
+    {
+        return device_;
+    }
+
+  private:
+    enum class CommandType : std::uint8_t
+    {
+        play,
+        stop,
+        set_gain,
+        stop_all,
+        set_master_gain,
+    };
+
+    struct Command
+    {
+        CommandType type;
+        bool loop;
+        VoiceId voice;
+        const Sound* sound;
+        float gain_left;
+        float gain_right;
+    };
+
+    struct Voice
+    {
+        VoiceId id;
+        const Sound* sound;
+        std::size_t position;
+        float gain_left;
+        float gain_right;
+        bool loop;
+    };
+
+    static void callback(void* user_data, Uint8* stream, int length) noexcept;
+    void mix(float* output, std::size_t n_frames) noexcept;
+    void apply(const Command& command) noexcept;
+
+    std::deque<Sound> sounds_;
+    VoiceId next_voice_{1};
+    int frequency_;
+
+    SpscQueue<Command, 1024> commands_;
+    // touched only by the audio callback
+    std::vector<Voice> voices_;
+    float master_gain_{1.0F};
+
+    // declared last so the device is closed, stopping the callback, before anything it uses is destroyed
+    AudioDevice device_;
+};
+
+} // namespace sdl::audio
@@ -0,0 +1,137 @@
+#include "sdlpp_capture.h"
+
+#include "sdlpp.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace sdl {
+
+namespace {
+
+Point<int> render_target_size(const Renderer& renderer)
+{
+    SDL_Texture* target = renderer.get_render_target();
+    if (target == nullptr) {
+        return renderer.output_size();
+    }
+    Point<int> size;
+    if (SDL_QueryTexture(target, nullptr, nullptr, &size.x, &size.y) != 0) {
+        throw GenericError{};
+    }
+    return size;
+}
+
+} // namespace
+
+SurfaceUniquePtr SurfacePool::acquire(int width, int height, Uint32 format)
+{
+    {
+        std::lock_guard lock{mutex_};
+        const auto found = std::find_if(surfaces_.begin(), surfaces_.end(), [=](const SurfaceUniquePtr& surface) {
+            return surface->w == width && surface->h == height && surface->format->format == format;
+        });
+        if (found != surfaces_.end()) {
+            SurfaceUniquePtr surface = std::move(*found);
+            surfaces_.erase(found);
+            return surface;
+        }
+    }
+    return make_surface(width, height, format);
+}
+
+void SurfacePool::release(SurfaceUniquePtr surface) noexcept
+{
+    if (surface == nullptr) {
+        return;
+    }
+    std::lock_guard lock{mutex_};
+    if (surfaces_.size() < max_pooled_) {
+        surfaces_.push_back(std::move(surface));
+    }
+}
+
+FrameCapturer::FrameCapturer(CaptureConfig config)
+    : config_{std::move(config)}, pool_{config_.max_pending + 2}, thread_{&FrameCapturer::run, this}
+{}
+
+FrameCapturer::~FrameCapturer()
+{
+    {
+        std::lock_guard lock{mutex_};
+        stopping_ = true;
+    }
+    capture_queued_.notify_one();
+    thread_.join();
+}
+
+void FrameCapturer::capture(const Renderer& renderer, std::string filename)
+{
+    SurfaceUniquePtr surface = pool_.acquire(render_target_size(renderer), config_.format);
+    try {
+        renderer.read_pixels(*surface);
+    } catch (...) {
+        pool_.release(std::move(surface));
+        throw;
+    }
+
+    SurfaceUniquePtr dropped;
+    {
+        std::lock_guard lock{mutex_};
+        ++statistics_.n_captured;
+        if (config_.max_pending != 0 && pending_.size() >= config_.max_pending) {
+            dropped = std::move(pending_.front().surface);
+            pending_.pop_front();
+            ++statistics_.n_dropped;
+        }
+        pending_.push_back(PendingCapture{std::move(surface), std::move(filename)});
+    }
+    capture_queued_.notify_one();
+    pool_.release(std::move(dropped));
+}
+
+void FrameCapturer::flush()
+{
+    std::unique_lock lock{mutex_};
+    idle_.wait(lock, [this] { return pending_.empty() && !encoding_; });
+}
+
+FrameCapturer::Statistics FrameCapturer::statistics() const
+{
+    std::lock_guard lock{mutex_};
+    return statistics_;
+}
+
+void FrameCapturer::run()
+{
+    while (true) {
+        PendingCapture capture;
+        {
+            std::unique_lock lock{mutex_};
+            capture_queued_.wait(lock, [this] { return stopping_ || !pending_.empty(); });
+            if (pending_.empty()) {
+                break;
+            }
+            capture = std::move(pending_.front());
+            pending_.pop_front();
+            encoding_ = true;
+        }
+
+        bool encoded = true;
+        try {
+            config_.encoder(capture.surface.get(), rw_from_file(capture.filename, "wb").get());
+        } catch (...) {
+            encoded = false;
+        }
+        pool_.release(std::move(capture.surface));
+
+        {
+            std::lock_guard lock{mutex_};
+            ++(encoded ? statistics_.n_encoded : statistics_.n_failed);
+            encoding_ = false;
+        }
+        idle_.notify_all();
+    }
+}
+
+} // namespace sdl
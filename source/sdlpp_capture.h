@@ -0,0 +1,101 @@
+#pragma once
+
+#include "sdlpp.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace sdl {
+
+// Thread-safe pool of staging surfaces reused across frames so readbacks do not allocate once warmed up.
+class SurfacePool
+{
+  public:
+    SurfacePool(std::size_t max_pooled = 8) noexcept : max_pooled_{max_pooled} {}
+
+    // returns a pooled surface with matching size and format, or a new one
+    [[nodiscard]] SurfaceUniquePtr acquire(int width, int height, Uint32 format);
+    [[nodiscard]] SurfaceUniquePtr acquire(Point<int> size, Uint32 format)
+    {
+        return acquire(size.x, size.y, format);
+    }
+
+    // returns `surface` to the pool, freeing it if the pool is full
+    void release(SurfaceUniquePtr surface) noexcept;
+
+  private:
+    std::size_t max_pooled_;
+    std::mutex mutex_;
+    std::vector<SurfaceUniquePtr> surfaces_;
+};
+
+// writes `surface` to `destination`; save_bmp_rw and image::save_png_rw fit this signature
+using SurfaceEncoder = std::function<void(SDL_Surface* surface, SDL_RWops* destination)>;
+
+struct CaptureConfig
+{
+    // captures waiting for the encoder; when full the oldest pending capture is dropped
+    std::size_t max_pending = 4;
+    Uint32 format = SDL_PIXELFORMAT_ARGB8888;
+    SurfaceEncoder encoder = save_bmp_rw;
+};
+
+// Reads back render targets into pooled surfaces on the calling (render) thread and encodes them to files on a
+// background thread. Works with any renderer that supports SDL_RenderReadPixels, including the software renderer
+// used under the offscreen and dummy video drivers.
+class FrameCapturer
+{
+  public:
+    struct Statistics
+    {
+        std::uint64_t n_captured;
+        std::uint64_t n_encoded;
+        std::uint64_t n_dropped;
+        std::uint64_t n_failed;
+    };
+
+    FrameCapturer(CaptureConfig config = {});
+    FrameCapturer(const FrameCapturer&) = delete;
+    FrameCapturer& operator=(const FrameCapturer&) = delete;
+    // encodes captures that are still pending before returning
+    ~FrameCapturer();
+
+    // reads back the renderer's current target and queues it to be encoded to `filename`
+    void capture(const Renderer& renderer, std::string filename);
+
+    // blocks until every queued capture has been encoded or has failed
+    void flush();
+
+    [[nodiscard]] Statistics statistics() const;
+
+  private:
+    struct PendingCapture
+    {
+        SurfaceUniquePtr surface;
+        std::string filename;
+    };
+
+    void run();
+
+    CaptureConfig config_;
+    SurfacePool pool_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable capture_queued_;
+    std::condition_variable idle_;
+    std::deque<PendingCapture> pending_;
+    bool encoding_{false};
+    bool stopping_{false};
+    Statistics statistics_{};
+
+    std::thread thread_;
+};
+
+} // namespace sdl
@@ -0,0 +1,588 @@
+#include "sdlpp_color_lut.h"
+
+#include "sdlpp.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SDLWRAP_HAVE_SSE2 1
+#endif
+
+namespace sdl {
+
+namespace {
+
+// below this many pixels per thread, waking threads costs more than it saves
+constexpr std::size_t min_pixels_per_thread = 65536;
+
+// lattice points are red, green, blue and an unused lane, so each point loads as one vector
+constexpr std::size_t red_stride = 4;
+// positions within a 3D LUT cell are counted in 255ths
+constexpr float step_weight = 1.0F / 255.0F;
+
+// where each channel of a 32-bit, 8 bits per channel format lives
+struct PixelLayout
+{
+    int red_shift;
+    int green_shift;
+    int blue_shift;
+    int alpha_shift;
+    bool has_alpha;
+
+    bool operator==(const PixelLayout&) const = default;
+};
+
+int channel_shift(Uint32 mask)
+{
+    const int shift = std::countr_zero(mask);
+    if (mask == 0 || (mask >> shift) != 0xFFU) {
+        throw std::invalid_argument{"color transforms need 8 bits per channel"};
+    }
+    return shift;
+}
+
+PixelLayout layout_from_masks(Uint32 red_mask, Uint32 green_mask, Uint32 blue_mask, Uint32 alpha_mask)
+{
+    return PixelLayout{
+        channel_shift(red_mask),
+        channel_shift(green_mask),
+        channel_shift(blue_mask),
+        alpha_mask == 0 ? 0 : channel_shift(alpha_mask),
+        alpha_mask != 0,
+    };
+}
+
+PixelLayout layout_of(const SDL_PixelFormat& format)
+{
+    if (format.BytesPerPixel != 4) {
+        throw std::invalid_argument{"color transforms need 32-bit pixels"};
+    }
+    return layout_from_masks(format.Rmask, format.Gmask, format.Bmask, format.Amask);
+}
+
+PixelLayout layout_of(Uint32 format)
+{
+    int bits_per_pixel = 0;
+    Uint32 masks[4] = {};
+    if (SDL_ISPIXELFORMAT_FOURCC(format) || SDL_BYTESPERPIXEL(format) != 4 ||
+        SDL_PixelFormatEnumToMasks(format, &bits_per_pixel, &masks[0], &masks[1], &masks[2], &masks[3]) != SDL_TRUE) {
+        throw std::invalid_argument{"color transforms need 32-bit pixels"};
+    }
+    return layout_from_masks(masks[0], masks[1], masks[2], masks[3]);
+}
+
+// only 8-bit indices are one byte per pixel; INDEX1 and INDEX4 surfaces are rejected like other formats
+bool is_indexed(const SDL_Surface& surface) noexcept
+{
+    return SDL_ISPIXELFORMAT_INDEXED(surface.format->format) && surface.format->BitsPerPixel == 8 &&
+           surface.format->palette != nullptr;
+}
+
+Uint32 pack(Color color, const PixelLayout& layout) noexcept
+{
+    Uint32 pixel = (Uint32{color.r} << layout.red_shift) | (Uint32{color.g} << layout.green_shift) |
+                   (Uint32{color.b} << layout.blue_shift);
+    if (layout.has_alpha) {
+        pixel |= Uint32{color.a} << layout.alpha_shift;
+    }
+    return pixel;
+}
+
+class SurfaceLock
+{
+  public:
+    explicit SurfaceLock(SDL_Surface& surface) : surface_{surface}
+    {
+        if (SDL_MUSTLOCK(&surface_) && SDL_LockSurface(&surface_) != 0) {
+            throw GenericError{};
+        }
+    }
+    SurfaceLock(const SurfaceLock&) = delete;
+    SurfaceLock& operator=(const SurfaceLock&) = delete;
+
+    ~SurfaceLock()
+    {
+        if (SDL_MUSTLOCK(&surface_)) {
+            SDL_UnlockSurface(&surface_);
+        }
+    }
+
+  private:
+    SDL_Surface& surface_;
+};
+
+std::uint8_t* pixel_address(const SDL_Surface& surface, int x, int y) noexcept
+{
+    return static_cast<std::uint8_t*>(surface.pixels) + static_cast<std::ptrdiff_t>(y) * surface.pitch +
+           static_cast<std::ptrdiff_t>(x) * surface.format->BytesPerPixel;
+}
+
+} // namespace
+
+ChannelCurves ChannelCurves::identity() noexcept
+{
+    ChannelCurves curves;
+    for (int value = 0; value < 256; ++value) {
+        const auto level = static_cast<std::uint8_t>(value);
+        curves.red[value] = level;
+        curves.green[value] = level;
+        curves.blue[value] = level;
+        curves.alpha[value] = level;
+    }
+    return curves;
+}
+
+ChannelCurves ChannelCurves::gamma(float gamma)
+{
+    if (!(gamma > 0.0F)) {
+        throw std::invalid_argument{"gamma must be positive"};
+    }
+    ChannelCurves curves = identity();
+    for (int value = 0; value < 256; ++value) {
+        const float corrected = std::pow(static_cast<float>(value) / 255.0F, 1.0F / gamma);
+        const auto level = static_cast<std::uint8_t>(std::lround(std::clamp(corrected, 0.0F, 1.0F) * 255.0F));
+        curves.red[value] = level;
+        curves.green[value] = level;
+        curves.blue[value] = level;
+    }
+    return curves;
+}
+
+ChannelCurves ChannelCurves::modulate(Color color) noexcept
+{
+    ChannelCurves curves;
+    const auto scale = [](int value, int factor) {
+        return static_cast<std::uint8_t>((value * factor + 127) / 255);
+    };
+    for (int value = 0; value < 256; ++value) {
+        curves.red[value] = scale(value, color.r);
+        curves.green[value] = scale(value, color.g);
+        curves.blue[value] = scale(value, color.b);
+        curves.alpha[value] = scale(value, color.a);
+    }
+    return curves;
+}
+
+ColorLut3d::ColorLut3d(int size, std::span<const Color> entries) : size_{size}
+{
+    if (size < 2 || size > 256) {
+        throw std::invalid_argument{"3D LUTs need between 2 and 256 points per axis"};
+    }
+    if (entries.size() != static_cast<std::size_t>(size) * size * size) {
+        throw std::invalid_argument{"3D LUT entry count does not match its size"};
+    }
+    entries_.reserve(4 * entries.size());
+    for (const Color& entry : entries) {
+        entries_.insert(
+            entries_.end(),
+            {static_cast<float>(entry.r), static_cast<float>(entry.g), static_cast<float>(entry.b), 0.0F}
+        );
+    }
+    const auto lattice_size = static_cast<std::size_t>(size);
+    green_stride_ = red_stride * lattice_size;
+    blue_stride_ = green_stride_ * lattice_size;
+    for (int value = 0; value < 256; ++value) {
+        // the last lattice point is reached as the far corner of the last cell
+        const int cell = std::min(value * (size - 1) / 255, size - 2);
+        steps_[value] = static_cast<std::uint8_t>(value * (size - 1) - cell * 255);
+        red_offsets_[value] = red_stride * static_cast<std::size_t>(cell);
+        green_offsets_[value] = green_stride_ * static_cast<std::size_t>(cell);
+        blue_offsets_[value] = blue_stride_ * static_cast<std::size_t>(cell);
+    }
+}
+
+Color ColorLut3d::map(Color color) const noexcept
+{
+    std::uint8_t output[4];
+    lookup(color.r, color.g, color.b, output);
+    return Color{output[0], output[1], output[2], color.a};
+}
+
+void ColorLut3d::lookup(int red, int green, int blue, std::uint8_t* output) const noexcept
+{
+    const int red_step = steps_[red];
+    const int green_step = steps_[green];
+    const int blue_step = steps_[blue];
+
+    // the cell splits into six tetrahedra along its diagonal; walking the axes in order of decreasing fraction picks
+    // the one containing the color. Integer selects rather than a sort keep noisy images free of branch mispredictions;
+    // tied axes have equal weights, so either order gives the same result.
+    const int high = std::max({red_step, green_step, blue_step});
+    const int low = std::min({red_step, green_step, blue_step});
+    const int middle = red_step + green_step + blue_step - high - low;
+    const std::size_t first_stride =
+        red_step == high ? red_stride : (green_step == high ? green_stride_ : blue_stride_);
+    const std::size_t last_stride = blue_step == low ? blue_stride_ : (green_step == low ? green_stride_ : red_stride);
+    const float* corner0 = entries_.data() + red_offsets_[red] + green_offsets_[green] + blue_offsets_[blue];
+    const float* corner1 = corner0 + first_stride;
+    const float* corner3 = corner0 + red_stride + green_stride_ + blue_stride_;
+    const float* corner2 = corner3 - last_stride;
+    const float high_weight = static_cast<float>(high) * step_weight;
+    const float middle_weight = static_cast<float>(middle) * step_weight;
+    const float low_weight = static_cast<float>(low) * step_weight;
+
+#ifdef SDLWRAP_HAVE_SSE2
+    const __m128 point0 = _mm_loadu_ps(corner0);
+    const __m128 point1 = _mm_loadu_ps(corner1);
+    const __m128 point2 = _mm_loadu_ps(corner2);
+    const __m128 point3 = _mm_loadu_ps(corner3);
+    __m128 result = _mm_add_ps(point0, _mm_mul_ps(_mm_set1_ps(high_weight), _mm_sub_ps(point1, point0)));
+    result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(middle_weight), _mm_sub_ps(point2, point1)));
+    result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(low_weight), _mm_sub_ps(point3, point2)));
+    // interpolation never leaves the 0-255 range of the lattice, and the packs saturate anyway
+    __m128i levels = _mm_cvtps_epi32(result);
+    levels = _mm_packs_epi32(levels, levels);
+    levels = _mm_packus_epi16(levels, levels);
+    const int packed = _mm_cvtsi128_si32(levels);
+    std::memcpy(output, &packed, 4);
+#else
+    for (int channel = 0; channel < 3; ++channel) {
+        const float value = corner0[channel] + high_weight * (corner1[channel] - corner0[channel]) +
+                            middle_weight * (corner2[channel] - corner1[channel]) +
+                            low_weight * (corner3[channel] - corner2[channel]);
+        // rounds half to even like _mm_cvtps_epi32, so both paths give the same colors
+        output[channel] = static_cast<std::uint8_t>(std::clamp(std::nearbyint(value), 0.0F, 255.0F));
+    }
+    output[3] = 0;
+#endif
+}
+
+// Converts rows of one pixel layout to another through the transform. Curves are folded into per-channel tables that
+// already hold each output level at its destination position, so a pixel costs four lookups plus the optional LUT.
+class ColorTransform::RowKernel
+{
+  public:
+    RowKernel(const ColorTransform& transform, const PixelLayout& source, const PixelLayout& destination)
+        : lut_{transform.lut_ ? &*transform.lut_ : nullptr},
+          source_{source},
+          copy_{!transform.lut_ && !transform.curves_ && source == destination}
+    {
+        const ChannelCurves curves = transform.curves_.value_or(ChannelCurves::identity());
+        for (int value = 0; value < 256; ++value) {
+            channels_[0][value] = Uint32{curves.red[value]} << destination.red_shift;
+            channels_[1][value] = Uint32{curves.green[value]} << destination.green_shift;
+            channels_[2][value] = Uint32{curves.blue[value]} << destination.blue_shift;
+            channels_[3][value] = destination.has_alpha ? Uint32{curves.alpha[value]} << destination.alpha_shift : 0;
+        }
+    }
+
+    RowKernel(const ColorTransform& transform, const SDL_Palette& palette, const PixelLayout& destination)
+        : lut_{nullptr}, source_{}, indexed_{true}
+    {
+        for (int index = 0; index < palette.ncolors && index < 256; ++index) {
+            palette_[index] = pack(transform.map(palette.colors[index]), destination);
+        }
+    }
+
+    void operator()(const std::uint8_t* source, std::uint8_t* destination, int width) const noexcept
+    {
+        auto* output = reinterpret_cast<Uint32*>(destination);
+        if (indexed_) {
+            for (int x = 0; x < width; ++x) {
+                output[x] = palette_[source[x]];
+            }
+            return;
+        }
+        if (copy_) {
+            std::memmove(destination, source, 4 * static_cast<std::size_t>(width));
+            return;
+        }
+
+        // output stores may alias members as far as the compiler knows, so everything read per pixel is hoisted
+        const auto* input = reinterpret_cast<const Uint32*>(source);
+        const PixelLayout layout = source_;
+        const Uint32 opaque = layout.has_alpha ? 0 : 0xFFU;
+        const Uint32* const red_levels = channels_[0].data();
+        const Uint32* const green_levels = channels_[1].data();
+        const Uint32* const blue_levels = channels_[2].data();
+        const Uint32* const alpha_levels = channels_[3].data();
+        if (lut_ == nullptr) {
+            for (int x = 0; x < width; ++x) {
+                const Uint32 pixel = input[x];
+                output[x] = red_levels[(pixel >> layout.red_shift) & 0xFFU] |
+                            green_levels[(pixel >> layout.green_shift) & 0xFFU] |
+                            blue_levels[(pixel >> layout.blue_shift) & 0xFFU] |
+                            alpha_levels[((pixel >> layout.alpha_shift) & 0xFFU) | opaque];
+            }
+            return;
+        }
+        const ColorLut3d& lut = *lut_;
+        for (int x = 0; x < width; ++x) {
+            const Uint32 pixel = input[x];
+            std::uint8_t graded[4];
+            lut.lookup(
+                static_cast<int>((pixel >> layout.red_shift) & 0xFFU),
+                static_cast<int>((pixel >> layout.green_shift) & 0xFFU),
+                static_cast<int>((pixel >> layout.blue_shift) & 0xFFU),
+                graded
+            );
+            output[x] = red_levels[graded[0]] | green_levels[graded[1]] | blue_levels[graded[2]] |
+                        alpha_levels[((pixel >> layout.alpha_shift) & 0xFFU) | opaque];
+        }
+    }
+
+  private:
+    const ColorLut3d* lut_;
+    PixelLayout source_;
+    bool indexed_{false};
+    bool copy_{false};
+    std::array<std::array<Uint32, 256>, 4> channels_{};
+    std::array<Uint32, 256> palette_{};
+};
+
+// Threads that live as long as the transform, so uploading dirty regions every frame does not start and join threads
+// for each of them.
+class ColorTransform::Workers
+{
+  public:
+    explicit Workers(std::size_t n_threads)
+    {
+        threads_.reserve(n_threads);
+        for (std::size_t index = 1; index <= n_threads; ++index) {
+            threads_.emplace_back(&Workers::work, this, index);
+        }
+    }
+    Workers(const Workers&) = delete;
+    Workers& operator=(const Workers&) = delete;
+
+    ~Workers()
+    {
+        {
+            const std::scoped_lock lock{mutex_};
+            stopping_ = true;
+        }
+        task_ready_.notify_all();
+        for (std::thread& thread : threads_) {
+            thread.join();
+        }
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept
+    {
+        return threads_.size();
+    }
+
+    // calls `function(index)` for every index up to size() on the workers and index 0 on the calling thread, and
+    // returns once all calls have; `function` must not throw
+    template <typename Function>
+    void run(Function& function)
+    {
+        {
+            const std::scoped_lock lock{mutex_};
+            task_ = [](void* context, std::size_t index) { (*static_cast<Function*>(context))(index); };
+            context_ = &function;
+            n_running_ = threads_.size();
+            ++generation_;
+        }
+        task_ready_.notify_all();
+        function(std::size_t{0});
+
+        std::unique_lock lock{mutex_};
+        task_done_.wait(lock, [this] { return n_running_ == 0; });
+    }
+
+  private:
+    void work(std::size_t index)
+    {
+        std::uint64_t generation = 0;
+        while (true) {
+            void (*task)(void*, std::size_t) = nullptr;
+            void* context = nullptr;
+            {
+                std::unique_lock lock{mutex_};
+                task_ready_.wait(lock, [&] { return stopping_ || generation_ != generation; });
+                if (stopping_) {
+                    return;
+                }
+                generation = generation_;
+                task = task_;
+                context = context_;
+            }
+            task(context, index);
+
+            const std::scoped_lock lock{mutex_};
+            if (--n_running_ == 0) {
+                task_done_.notify_one();
+            }
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable task_ready_;
+    std::condition_variable task_done_;
+    void (*task_)(void*, std::size_t){nullptr};
+    void* context_{nullptr};
+    std::size_t n_running_{0};
+    std::uint64_t generation_{0};
+    bool stopping_{false};
+    std::vector<std::thread> threads_;
+};
+
+ColorTransform::ColorTransform() = default;
+
+ColorTransform::ColorTransform(const ColorTransform& other) : curves_{other.curves_}, lut_{other.lut_}
+{
+}
+
+ColorTransform::ColorTransform(ColorTransform&& other) noexcept = default;
+
+ColorTransform& ColorTransform::operator=(const ColorTransform& other)
+{
+    curves_ = other.curves_;
+    lut_ = other.lut_;
+    return *this;
+}
+
+ColorTransform& ColorTransform::operator=(ColorTransform&& other) noexcept = default;
+ColorTransform::~ColorTransform() = default;
+
+template <typename Function>
+void ColorTransform::parallel_rows(int height, std::size_t pixels_per_row, std::size_t n_threads, Function function)
+    const
+{
+    const auto n_rows = static_cast<std::size_t>(height);
+    n_threads = std::clamp(
+        n_rows * pixels_per_row / min_pixels_per_thread, std::size_t{1}, std::max(n_threads, std::size_t{1})
+    );
+    if (n_threads == 1) {
+        function(0, height);
+        return;
+    }
+    if (workers_ == nullptr || workers_->size() != n_threads - 1) {
+        workers_.reset();
+        workers_ = std::make_unique<Workers>(n_threads - 1);
+    }
+    const int chunk = static_cast<int>((n_rows + n_threads - 1) / n_threads);
+    auto run_band = [&](std::size_t index) {
+        const int first = static_cast<int>(index) * chunk;
+        if (first < height) {
+            function(first, std::min(first + chunk, height));
+        }
+    };
+    workers_->run(run_band);
+}
+
+void ColorTransform::set_curves(const ChannelCurves& curves)
+{
+    curves_ = curves;
+}
+
+void ColorTransform::set_lut(ColorLut3d lut)
+{
+    lut_ = std::move(lut);
+}
+
+void ColorTransform::reset() noexcept
+{
+    curves_.reset();
+    lut_.reset();
+}
+
+Color ColorTransform::map(Color color) const noexcept
+{
+    if (lut_) {
+        color = lut_->map(color);
+    }
+    if (curves_) {
+        color = Color{curves_->red[color.r], curves_->green[color.g], curves_->blue[color.b], curves_->alpha[color.a]};
+    }
+    return color;
+}
+
+void ColorTransform::apply(SDL_Surface& surface, std::size_t n_threads) const
+{
+    if (is_indexed(surface)) {
+        const SDL_Palette& palette = *surface.format->palette;
+        std::vector<Color> colors(palette.colors, palette.colors + palette.ncolors);
+        for (Color& color : colors) {
+            color = map(color);
+        }
+        set_palette(surface, colors);
+        return;
+    }
+    if (lut_ || curves_) {
+        apply(surface, surface, n_threads);
+    }
+}
+
+void ColorTransform::apply(SDL_Surface& source, SDL_Surface& destination, std::size_t n_threads) const
+{
+    if (source.w != destination.w || source.h != destination.h) {
+        throw std::invalid_argument{"color transform source and destination differ in size"};
+    }
+    const PixelLayout destination_layout = layout_of(*destination.format);
+    const RowKernel kernel = is_indexed(source) ? RowKernel{*this, *source.format->palette, destination_layout}
+                                                : RowKernel{*this, layout_of(*source.format), destination_layout};
+
+    const SurfaceLock source_lock{source};
+    // locks nest, so transforming a surface in place locks it twice
+    const SurfaceLock destination_lock{destination};
+    parallel_rows(source.h, static_cast<std::size_t>(source.w), n_threads, [&](int first, int last) {
+        for (int y = first; y < last; ++y) {
+            kernel(pixel_address(source, 0, y), pixel_address(destination, 0, y), source.w);
+        }
+    });
+}
+
+void ColorTransform::upload(
+    SDL_Surface& source, SDL_Texture& texture, std::span<const Rectangle<int>> regions, std::size_t n_threads
+) const
+{
+    Uint32 format = 0;
+    int width = 0;
+    int height = 0;
+    if (SDL_QueryTexture(&texture, &format, nullptr, &width, &height) != 0) {
+        throw GenericError{};
+    }
+    if (source.w != width || source.h != height) {
+        throw std::invalid_argument{"color transform source and texture differ in size"};
+    }
+    const PixelLayout destination_layout = layout_of(format);
+    const RowKernel kernel = is_indexed(source) ? RowKernel{*this, *source.format->palette, destination_layout}
+                                                : RowKernel{*this, layout_of(*source.format), destination_layout};
+
+    const Rectangle<int> whole{0, 0, width, height};
+    const SurfaceLock source_lock{source};
+    for (const Rectangle<int>& region : regions.empty() ? std::span{&whole, 1} : regions) {
+        const int left = std::max(region.x, 0);
+        const int top = std::max(region.y, 0);
+        const int right = std::min(region.x + region.w, width);
+        const int bottom = std::min(region.y + region.h, height);
+        if (left >= right || top >= bottom) {
+            continue;
+        }
+        const Rectangle<int> clipped{left, top, right - left, bottom - top};
+        void* pixels = nullptr;
+        int pitch = 0;
+        if (SDL_LockTexture(&texture, &clipped, &pixels, &pitch) != 0) {
+            throw GenericError{};
+        }
+        parallel_rows(clipped.h, static_cast<std::size_t>(clipped.w), n_threads, [&](int first, int last) {
+            for (int y = first; y < last; ++y) {
+                auto* output = static_cast<std::uint8_t*>(pixels) + static_cast<std::ptrdiff_t>(y) * pitch;
+                kernel(pixel_address(source, clipped.x, clipped.y + y), output, clipped.w);
+            }
+        });
+        SDL_UnlockTexture(&texture);
+    }
+}
+
+void set_palette(SDL_Surface& surface, std::span<const Color> colors, int first)
+{
+    if (surface.format->palette == nullptr) {
+        throw std::invalid_argument{"surface has no palette"};
+    }
+    if (SDL_SetPaletteColors(surface.format->palette, colors.data(), first, static_cast<int>(colors.size())) != 0) {
+        throw GenericError{};
+    }
+}
+
+} // namespace sdl
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "sdlpp.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace sdl {
+
+// an 8-bit transfer curve per channel
+struct ChannelCurves
+{
+    std::array<std::uint8_t, 256> red;
+    std::array<std::uint8_t, 256> green;
+    std::array<std::uint8_t, 256> blue;
+    std::array<std::uint8_t, 256> alpha;
+
+    [[nodiscard]] static ChannelCurves identity() noexcept;
+    // raises the color channels to 1 / `gamma`, leaving alpha
+    [[nodiscard]] static ChannelCurves gamma(float gamma);
+    // multiplies each channel by `color`'s, like texture color and alpha modulation
+    [[nodiscard]] static ChannelCurves modulate(Color color) noexcept;
+};
+
+// Lattice of size^3 colors over RGB, looked up with tetrahedral interpolation. Alpha passes through unchanged.
+class ColorLut3d
+{
+  public:
+    // `entries` lists the lattice with red varying fastest and blue slowest, the order .cube files use
+    ColorLut3d(int size, std::span<const Color> entries);
+
+    // samples `function` at every lattice point
+    template <typename Function>
+    [[nodiscard]] static ColorLut3d from_function(int size, Function function);
+
+    [[nodiscard]] Color map(Color color) const noexcept;
+
+    [[nodiscard]] int size() const noexcept
+    {
+        return size_;
+    }
+
+  private:
+    friend class ColorTransform;
+
+    // writes the interpolated red, green and blue of an input color, and an unused fourth byte, to `output`
+    void lookup(int red, int green, int blue, std::uint8_t* output) const noexcept;
+
+    int size_;
+    // red, green, blue and an unused lane per lattice point, so each point loads as one vector
+    std::vector<float> entries_;
+    std::size_t green_stride_;
+    std::size_t blue_stride_;
+    // for each 8-bit channel value, the offset of its lattice cell along that channel's axis and its position within
+    // the cell in 255ths
+    std::array<std::size_t, 256> red_offsets_;
+    std::array<std::size_t, 256> green_offsets_;
+    std::array<std::size_t, 256> blue_offsets_;
+    std::array<std::uint8_t, 256> steps_;
+};
+
+template <typename Function>
+ColorLut3d ColorLut3d::from_function(int size, Function function)
+{
+    if (size < 2) {
+        throw std::invalid_argument{"3D LUTs need at least two points per axis"};
+    }
+    const auto scale = [size](int index) {
+        return static_cast<Uint8>((index * 255 + (size - 1) / 2) / (size - 1));
+    };
+    std::vector<Color> entries;
+    entries.reserve(static_cast<std::size_t>(size) * size * size);
+    for (int blue = 0; blue < size; ++blue) {
+        for (int green = 0; green < size; ++green) {
+            for (int red = 0; red < size; ++red) {
+                entries.push_back(function(Color{scale(red), scale(green), scale(blue), 255}));
+            }
+        }
+    }
+    return ColorLut3d{size, entries};
+}
+
+// Color grading pipeline: an optional 3D LUT followed by optional per-channel curves. Surfaces may be 32-bit with 8
+// bits per channel in any order, or 8-bit indexed; indexed pixels are never touched, only their palette is transformed.
+// `n_threads` > 1 splits large images across that many threads, which are kept between calls; a transform must not be
+// applied from several threads at once.
+class ColorTransform
+{
+  public:
+    ColorTransform();
+    // copies the curves and LUT, not the threads
+    ColorTransform(const ColorTransform& other);
+    ColorTransform(ColorTransform&& other) noexcept;
+    ColorTransform& operator=(const ColorTransform& other);
+    ColorTransform& operator=(ColorTransform&& other) noexcept;
+    ~ColorTransform();
+
+    void set_curves(const ChannelCurves& curves);
+    void set_lut(ColorLut3d lut);
+    // back to the identity transform
+    void reset() noexcept;
+
+    [[nodiscard]] Color map(Color color) const noexcept;
+
+    // transforms `surface` in place; for an indexed surface this rewrites the palette only
+    void apply(SDL_Surface& surface, std::size_t n_threads = 1) const;
+    // writes the transformed `source` to `destination`, which must have the same size and a 32-bit format
+    void apply(SDL_Surface& source, SDL_Surface& destination, std::size_t n_threads = 1) const;
+    // writes the transformed `regions` of `source` to the same regions of a streaming `texture` of the same size, or
+    // the whole surface when `regions` is empty, so only pixels that changed are converted and uploaded
+    void upload(
+        SDL_Surface& source,
+        SDL_Texture& texture,
+        std::span<const Rectangle<int>> regions = {},
+        std::size_t n_threads = 1
+    ) const;
+
+  private:
+    class RowKernel;
+    class Workers;
+
+    // calls `function(first, last)` on bands of rows, spread over up to `n_threads` threads
+    template <typename Function>
+    void parallel_rows(int height, std::size_t pixels_per_row, std::size_t n_threads, Function function) const;
+
+    std::optional<ChannelCurves> curves_;
+    std::optional<ColorLut3d> lut_;
+    // started on the first call that needs them
+    mutable std::unique_ptr<Workers> workers_;
+};
+
+// replaces the colors of an indexed surface's palette, starting at `first`, without touching its pixels
+void set_palette(SDL_Surface& surface, std::span<const Color> colors, int first = 0);
+
+} // namespace sdl
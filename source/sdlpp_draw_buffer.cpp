@@ -0,0 +1,176 @@
+#include "sdlpp_draw_buffer.h"
+
+#include "sdlpp.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <optional>
+
+namespace sdl {
+
+namespace {
+
+std::uint64_t state_key(const DrawState& state) noexcept
+{
+    // blend mode in the high bits so replay switches blend mode least often
+    return (static_cast<std::uint64_t>(state.blend_mode) << 32U) | (static_cast<std::uint64_t>(state.color.r) << 24U) |
+           (static_cast<std::uint64_t>(state.color.g) << 16U) | (static_cast<std::uint64_t>(state.color.b) << 8U) |
+           static_cast<std::uint64_t>(state.color.a);
+}
+
+} // namespace
+
+DrawCommandBuffer::Batch& DrawCommandBuffer::current_batch()
+{
+    if (current_batch_ == no_batch) {
+        const std::uint64_t key = state_key(state_);
+        const auto found = std::find_if(batches_.begin(), batches_.end(), [key](const Batch& batch) {
+            return batch.key == key;
+        });
+        if (found == batches_.end()) {
+            batches_.push_back(Batch{state_, key, {}, {}, {}, {}, {}, {}});
+            current_batch_ = batches_.size() - 1;
+        } else {
+            current_batch_ = static_cast<std::size_t>(found - batches_.begin());
+        }
+    }
+    return batches_[current_batch_];
+}
+
+void DrawCommandBuffer::draw_point(Point<float> point)
+{
+    current_batch().points.push_back(point);
+}
+
+void DrawCommandBuffer::draw_points(std::span<const Point<float>> points)
+{
+    auto& batch_points = current_batch().points;
+    batch_points.insert(batch_points.end(), points.begin(), points.end());
+}
+
+void DrawCommandBuffer::draw_line(Point<float> begin, Point<float> end)
+{
+    Batch& batch = current_batch();
+    // A quad one pixel wide through the pixel centers, reaching half a pixel past both ends so the end pixels are
+    // covered as SDL_RenderDrawLine covers them. A zero length line becomes a one pixel square.
+    const float delta_x = end.x - begin.x;
+    const float delta_y = end.y - begin.y;
+    const float length = std::hypot(delta_x, delta_y);
+    const Point<float> along =
+        length > 0.0F ? Point<float>{0.5F * delta_x / length, 0.5F * delta_y / length} : Point<float>{0.5F, 0.0F};
+    const Point<float> across{-along.y, along.x};
+    const auto corner = [&batch](Point<float> point, Point<float> offset) {
+        return SDL_Vertex{{point.x + 0.5F + offset.x, point.y + 0.5F + offset.y}, batch.state.color, {0.0F, 0.0F}};
+    };
+    const SDL_Vertex begin_left = corner(begin, {-along.x + across.x, -along.y + across.y});
+    const SDL_Vertex begin_right = corner(begin, {-along.x - across.x, -along.y - across.y});
+    const SDL_Vertex end_left = corner(end, {along.x + across.x, along.y + across.y});
+    const SDL_Vertex end_right = corner(end, {along.x - across.x, along.y - across.y});
+    batch.segment_vertices.insert(
+        batch.segment_vertices.end(), {begin_left, begin_right, end_right, begin_left, end_right, end_left}
+    );
+}
+
+void DrawCommandBuffer::draw_lines(std::span<const Point<float>> points)
+{
+    if (points.size() < 2) {
+        return;
+    }
+    Batch& batch = current_batch();
+    batch.line_vertices.insert(batch.line_vertices.end(), points.begin(), points.end());
+    batch.line_strip_ends.push_back(batch.line_vertices.size());
+}
+
+void DrawCommandBuffer::draw_rectangle(const Rectangle<float>& rectangle)
+{
+    current_batch().outlines.push_back(rectangle);
+}
+
+void DrawCommandBuffer::draw_rectangles(std::span<const Rectangle<float>> rectangles)
+{
+    auto& outlines = current_batch().outlines;
+    outlines.insert(outlines.end(), rectangles.begin(), rectangles.end());
+}
+
+void DrawCommandBuffer::fill_rectangle(const Rectangle<float>& rectangle)
+{
+    current_batch().fills.push_back(rectangle);
+}
+
+void DrawCommandBuffer::fill_rectangles(std::span<const Rectangle<float>> rectangles)
+{
+    auto& fills = current_batch().fills;
+    fills.insert(fills.end(), rectangles.begin(), rectangles.end());
+}
+
+void DrawCommandBuffer::submit(const Renderer& renderer) const
+{
+    if (empty()) {
+        return;
+    }
+
+    std::vector<std::size_t> order(batches_.size());
+    std::iota(order.begin(), order.end(), std::size_t{0});
+    std::sort(order.begin(), order.end(), [this](std::size_t lhs, std::size_t rhs) {
+        return batches_[lhs].key < batches_[rhs].key;
+    });
+
+    const Color saved_color = renderer.get_draw_color();
+    const SDL_BlendMode saved_blend_mode = renderer.get_draw_blend_mode();
+
+    std::optional<SDL_BlendMode> blend_mode;
+    for (const std::size_t index : order) {
+        const Batch& batch = batches_[index];
+        if (batch.empty()) {
+            continue;
+        }
+        if (blend_mode != batch.state.blend_mode) {
+            renderer.set_draw_blend_mode(batch.state.blend_mode);
+            blend_mode = batch.state.blend_mode;
+        }
+        renderer.set_draw_color(batch.state.color);
+
+        if (!batch.fills.empty()) {
+            renderer.fill_rectangles(std::span{batch.fills});
+        }
+        if (!batch.outlines.empty()) {
+            renderer.draw_rectangles(std::span{batch.outlines});
+        }
+        if (!batch.segment_vertices.empty()) {
+            renderer.render_geometry(nullptr, std::span{batch.segment_vertices});
+        }
+        std::size_t strip_begin = 0;
+        for (const std::size_t strip_end : batch.line_strip_ends) {
+            renderer.draw_lines(std::span{batch.line_vertices}.subspan(strip_begin, strip_end - strip_begin));
+            strip_begin = strip_end;
+        }
+        if (!batch.points.empty()) {
+            renderer.draw_points(std::span{batch.points});
+        }
+    }
+
+    renderer.set_draw_blend_mode(saved_blend_mode);
+    renderer.set_draw_color(saved_color);
+}
+
+void DrawCommandBuffer::reset() noexcept
+{
+    std::erase_if(batches_, [](const Batch& batch) { return batch.empty(); });
+    for (Batch& batch : batches_) {
+        batch.fills.clear();
+        batch.outlines.clear();
+        batch.segment_vertices.clear();
+        batch.line_vertices.clear();
+        batch.line_strip_ends.clear();
+        batch.points.clear();
+    }
+    current_batch_ = no_batch;
+}
+
+bool DrawCommandBuffer::empty() const noexcept
+{
+    return std::all_of(batches_.begin(), batches_.end(), [](const Batch& batch) { return batch.empty(); });
+}
+
+} // namespace sdl
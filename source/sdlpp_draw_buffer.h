@@ -0,0 +1,106 @@
+#pragma once
+
+#include "sdlpp.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace sdl {
+
+struct DrawState
+{
+    Color color;
+    SDL_BlendMode blend_mode;
+};
+
+// Records primitives together with the draw color and blend mode they were issued under and replays them grouped by
+// state, so a frame costs one set_draw_color/set_draw_blend_mode pair per distinct state instead of per primitive.
+// Within a state, filled rectangles replay first, then rectangle outlines, single lines, polylines and points, each
+// kind in recording order. Ordering between different states is not preserved.
+class DrawCommandBuffer
+{
+  public:
+    DrawCommandBuffer(DrawState initial_state = {{255, 255, 255, 255}, SDL_BLENDMODE_NONE}) noexcept
+        : state_{initial_state}
+    {}
+
+    void set_draw_color(const Color& color) noexcept
+    {
+        state_.color = color;
+        current_batch_ = no_batch;
+    }
+
+    void set_draw_blend_mode(SDL_BlendMode mode) noexcept
+    {
+        state_.blend_mode = mode;
+        current_batch_ = no_batch;
+    }
+
+    [[nodiscard]] DrawState get_draw_state() const noexcept
+    {
+        return state_;
+    }
+
+    void draw_point(Point<float> point);
+    void draw_points(std::span<const Point<float>> points);
+
+    // Single lines of a state are drawn together as one pixel wide quads in one render_geometry call. They are
+    // rasterized as triangles, not stepped like Renderer::draw_line: diagonal lines cover a slightly different set of
+    // pixels, and end pixels are covered by the half pixel caps rather than by the line endpoint rule. Record
+    // two-point polylines with draw_lines where pixel-exact output matters.
+    void draw_line(Point<float> begin, Point<float> end);
+    // records a connected polyline through `points`, drawn with its own draw_lines call exactly like
+    // Renderer::draw_lines
+    void draw_lines(std::span<const Point<float>> points);
+
+    void draw_rectangle(const Rectangle<float>& rectangle);
+    void draw_rectangles(std::span<const Rectangle<float>> rectangles);
+
+    void fill_rectangle(const Rectangle<float>& rectangle);
+    void fill_rectangles(std::span<const Rectangle<float>> rectangles);
+
+    // replays every recorded primitive, then restores the renderer's draw color and blend mode
+    void submit(const Renderer& renderer) const;
+
+    // discards recorded primitives but keeps the allocated storage of states that were used since the last reset
+    void reset() noexcept;
+
+    [[nodiscard]] bool empty() const noexcept;
+    [[nodiscard]] std::size_t n_states() const noexcept
+    {
+        return batches_.size();
+    }
+
+  private:
+    static constexpr std::size_t no_batch = static_cast<std::size_t>(-1);
+
+    struct Batch
+    {
+        DrawState state;
+        std::uint64_t key;
+        std::vector<Rectangle<float>> fills;
+        std::vector<Rectangle<float>> outlines;
+        // two triangles per single line
+        std::vector<SDL_Vertex> segment_vertices;
+        std::vector<Point<float>> line_vertices;
+        // one past the last vertex of each polyline in `line_vertices`
+        std::vector<std::size_t> line_strip_ends;
+        std::vector<Point<float>> points;
+
+        [[nodiscard]] bool empty() const noexcept
+        {
+            return fills.empty() && outlines.empty() && segment_vertices.empty() && line_vertices.empty() &&
+                   points.empty();
+        }
+    };
+
+    Batch& current_batch();
+
+    DrawState state_;
+    std::size_t current_batch_{no_batch};
+    std::vector<Batch> batches_;
+};
+
+} // namespace sdl
@@ -0,0 +1,251 @@
+#include "sdlpp_event_log.h"
+
+#include "sdlpp.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+namespace sdl {
+
+namespace {
+
+constexpr std::array<std::uint8_t, 8> log_magic = {'S', 'D', 'L', 'W', 'E', 'V', 'T', 1};
+constexpr std::size_t record_header_size = 5;
+// records are handed to the writer thread once this much has been buffered
+constexpr std::size_t write_block_size = 64 * 1024;
+
+bool is_recordable(Uint32 type) noexcept
+{
+    switch (type) {
+    case SDL_SYSWMEVENT:
+    case SDL_TEXTEDITING_EXT:
+    case SDL_DROPFILE:
+    case SDL_DROPTEXT:
+        return false;
+    default:
+        return type < SDL_USEREVENT;
+    }
+}
+
+void append_le32(std::vector<std::uint8_t>& buffer, Uint32 value)
+{
+    for (int shift = 0; shift < 32; shift += 8) {
+        buffer.push_back(static_cast<std::uint8_t>(value >> shift));
+    }
+}
+
+Uint32 read_le32(const std::uint8_t* bytes) noexcept
+{
+    return Uint32{bytes[0]} | (Uint32{bytes[1]} << 8U) | (Uint32{bytes[2]} << 16U) | (Uint32{bytes[3]} << 24U);
+}
+
+} // namespace
+
+EventRecorder::EventRecorder(RWOps destination) : destination_{std::move(destination)}, start_ticks_{SDL_GetTicks()}
+{
+    buffer_.reserve(write_block_size + sizeof(Event) + record_header_size);
+    buffer_.insert(buffer_.end(), log_magic.begin(), log_magic.end());
+    writer_ = std::thread{&EventRecorder::write, this};
+    try {
+        add_event_watch(&EventRecorder::watch, this);
+    } catch (...) {
+        {
+            const std::scoped_lock lock{mutex_};
+            stopping_ = true;
+        }
+        block_submitted_.notify_one();
+        writer_.join();
+        throw;
+    }
+    watching_ = true;
+}
+
+EventRecorder::~EventRecorder()
+{
+    try {
+        stop();
+    } catch (...) {
+        // a destructor cannot report a failed write; call stop() first to see it
+    }
+    {
+        const std::scoped_lock lock{mutex_};
+        stopping_ = true;
+    }
+    block_submitted_.notify_one();
+    writer_.join();
+}
+
+void EventRecorder::stop()
+{
+    if (watching_) {
+        remove_event_watch(&EventRecorder::watch, this);
+        watching_ = false;
+    }
+    flush();
+}
+
+void EventRecorder::flush()
+{
+    std::unique_lock lock{mutex_};
+    if (!buffer_.empty()) {
+        submit_buffer();
+    }
+    blocks_written_.wait(lock, [this] { return full_blocks_.empty() && !writing_; });
+    if (error_) {
+        std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+}
+
+std::size_t EventRecorder::n_recorded() const
+{
+    const std::scoped_lock lock{mutex_};
+    return n_recorded_;
+}
+
+int EventRecorder::watch(void* user_data, Event* event)
+{
+    if (is_recordable(event->type)) {
+        try {
+            static_cast<EventRecorder*>(user_data)->record(*event);
+        } catch (...) {
+            // the watch runs inside SDL and must not throw; a record that could not be buffered is lost
+        }
+    }
+    return 0;
+}
+
+void EventRecorder::record(const Event& event)
+{
+    const auto* const bytes = reinterpret_cast<const std::uint8_t*>(&event);
+    std::size_t length = sizeof(Event);
+    while (length > 0 && bytes[length - 1] == 0) {
+        --length;
+    }
+    const Uint32 time = event.common.timestamp >= start_ticks_ ? event.common.timestamp - start_ticks_ : 0;
+
+    const std::scoped_lock lock{mutex_};
+    append_le32(buffer_, time);
+    buffer_.push_back(static_cast<std::uint8_t>(length));
+    buffer_.insert(buffer_.end(), bytes, bytes + length);
+    ++n_recorded_;
+    if (buffer_.size() >= write_block_size) {
+        submit_buffer();
+    }
+}
+
+void EventRecorder::submit_buffer()
+{
+    std::vector<std::uint8_t> next;
+    if (!free_blocks_.empty()) {
+        next = std::move(free_blocks_.back());
+        free_blocks_.pop_back();
+    }
+    full_blocks_.push_back(std::exchange(buffer_, std::move(next)));
+    buffer_.reserve(write_block_size + sizeof(Event) + record_header_size);
+    block_submitted_.notify_one();
+}
+
+void EventRecorder::write()
+{
+    std::vector<std::vector<std::uint8_t>> blocks;
+    std::unique_lock lock{mutex_};
+    while (true) {
+        block_submitted_.wait(lock, [this] { return stopping_ || !full_blocks_.empty(); });
+        if (full_blocks_.empty()) {
+            return;
+        }
+        blocks.swap(full_blocks_);
+        writing_ = true;
+        // after a failed write, blocks are dropped until flush() has reported it, so the log does not silently
+        // continue past a gap
+        std::exception_ptr error = error_;
+        lock.unlock();
+
+        for (std::vector<std::uint8_t>& block : blocks) {
+            try {
+                if (!error) {
+                    destination_.write(block.data(), 1, block.size());
+                }
+            } catch (...) {
+                error = std::current_exception();
+            }
+            block.clear();
+        }
+
+        lock.lock();
+        error_ = error;
+        std::move(blocks.begin(), blocks.end(), std::back_inserter(free_blocks_));
+        blocks.clear();
+        writing_ = false;
+        blocks_written_.notify_all();
+    }
+}
+
+std::vector<RecordedEvent> read_event_log(RWOps source)
+{
+    std::vector<std::uint8_t> log(static_cast<std::size_t>(source.size()));
+    if (!log.empty()) {
+        static_cast<void>(source.read(1, log.size(), log.data()));
+    }
+    if (log.size() < log_magic.size() || !std::equal(log_magic.begin(), log_magic.end(), log.begin())) {
+        throw std::runtime_error{"not an event log"};
+    }
+
+    std::vector<RecordedEvent> events;
+    std::size_t position = log_magic.size();
+    while (position < log.size()) {
+        if (log.size() - position < record_header_size) {
+            throw std::runtime_error{"truncated event log"};
+        }
+        RecordedEvent recorded{read_le32(&log[position]), Event{}};
+        const std::size_t length = log[position + 4];
+        position += record_header_size;
+        if (length > sizeof(Event) || log.size() - position < length) {
+            throw std::runtime_error{"truncated event log"};
+        }
+        std::memcpy(&recorded.event, &log[position], length);
+        position += length;
+        events.push_back(recorded);
+    }
+    // events pushed from other threads may be recorded slightly out of order
+    std::stable_sort(events.begin(), events.end(), [](const RecordedEvent& lhs, const RecordedEvent& rhs) {
+        return lhs.time < rhs.time;
+    });
+    return events;
+}
+
+EventReplayer::EventReplayer(std::vector<RecordedEvent> events, const ReplayConfig& config)
+    : events_{std::move(events)}, config_{config}
+{}
+
+EventReplayer::EventReplayer(RWOps source, const ReplayConfig& config)
+    : EventReplayer{read_event_log(std::move(source)), config}
+{}
+
+bool EventReplayer::advance_frame()
+{
+    if (finished()) {
+        return false;
+    }
+    if (config_.speed == ReplaySpeed::real_time) {
+        if (!started_) {
+            start_ticks_ = SDL_GetTicks64();
+        }
+        clock_ = static_cast<Uint32>(SDL_GetTicks64() - start_ticks_);
+    } else if (started_) {
+        clock_ += config_.frame_milliseconds;
+    }
+    started_ = true;
+
+    while (next_ < events_.size() && events_[next_].time <= clock_) {
+        static_cast<void>(push_event(events_[next_].event));
+        ++next_;
+    }
+    return true;
+}
+
+} // namespace sdl
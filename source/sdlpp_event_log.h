@@ -0,0 +1,130 @@
+#pragma once
+
+#include "sdlpp.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sdl {
+
+// Event logs are a short header followed by one record per event: the milliseconds since recording started, the
+// payload length and the SDL_Event bytes up to the last non-zero one. Payloads are stored in host byte order, so a log
+// replays on the platform it was recorded on. Events carrying pointers (drops, user events, window manager messages)
+// are not recorded.
+struct RecordedEvent
+{
+    Uint32 time;
+    Event event;
+};
+
+// Records every event SDL dispatches, via an event watch, until stopped or destroyed. Records are buffered, and full
+// blocks are handed to a writer thread, so the watch never waits for the destination.
+class EventRecorder
+{
+  public:
+    explicit EventRecorder(RWOps destination);
+    EventRecorder(const EventRecorder&) = delete;
+    EventRecorder& operator=(const EventRecorder&) = delete;
+    ~EventRecorder();
+
+    // removes the event watch and writes out everything recorded so far
+    void stop();
+    // waits until everything recorded so far is written; rethrows the first write error
+    void flush();
+
+    [[nodiscard]] std::size_t n_recorded() const;
+
+  private:
+    static int watch(void* user_data, Event* event);
+    void record(const Event& event);
+    // hands `buffer_` to the writer thread; requires `mutex_`
+    void submit_buffer();
+    void write();
+
+    // touched only by the writer thread once it has started
+    RWOps destination_;
+
+    Uint32 start_ticks_;
+    bool watching_{false};
+
+    mutable std::mutex mutex_;
+    std::condition_variable block_submitted_;
+    std::condition_variable blocks_written_;
+    std::vector<std::uint8_t> buffer_;
+    // blocks waiting for the writer thread, oldest first, and written blocks kept for reuse
+    std::vector<std::vector<std::uint8_t>> full_blocks_;
+    std::vector<std::vector<std::uint8_t>> free_blocks_;
+    bool writing_{false};
+    std::size_t n_recorded_{0};
+    std::exception_ptr error_;
+    bool stopping_{false};
+
+    std::thread writer_;
+};
+
+[[nodiscard]] std::vector<RecordedEvent> read_event_log(RWOps source);
+
+enum class ReplaySpeed
+{
+    // the replay clock follows the wall clock, reproducing the original pacing
+    real_time,
+    // the replay clock advances by a fixed step per frame, however long the frame took
+    fastest,
+};
+
+struct ReplayConfig
+{
+    ReplaySpeed speed = ReplaySpeed::fastest;
+    // replay clock step per frame in fastest mode
+    Uint32 frame_milliseconds = 16;
+};
+
+// Pushes recorded events back into the SDL queue, frame by frame. Drive the frame loop's notion of time from clock()
+// so that a fastest-mode replay runs the same simulation as the recorded session, only without waiting.
+class EventReplayer
+{
+  public:
+    explicit EventReplayer(std::vector<RecordedEvent> events, const ReplayConfig& config = {});
+    explicit EventReplayer(RWOps source, const ReplayConfig& config = {});
+
+    // advances the replay clock by one frame and pushes every event recorded up to it; returns false, without
+    // advancing, once an earlier frame has pushed the last event
+    bool advance_frame();
+
+    // milliseconds of recording replayed so far
+    [[nodiscard]] Uint32 clock() const noexcept
+    {
+        return clock_;
+    }
+
+    [[nodiscard]] Uint32 duration() const noexcept
+    {
+        return events_.empty() ? 0 : events_.back().time;
+    }
+
+    [[nodiscard]] bool finished() const noexcept
+    {
+        return next_ == events_.size();
+    }
+
+    [[nodiscard]] std::size_t n_pushed() const noexcept
+    {
+        return next_;
+    }
+
+  private:
+    std::vector<RecordedEvent> events_;
+    ReplayConfig config_;
+    std::size_t next_{0};
+    Uint32 clock_{0};
+    // wall clock tick of the first frame in real-time mode
+    std::uint64_t start_ticks_{0};
+    bool started_{false};
+};
+
+} // namespace sdl
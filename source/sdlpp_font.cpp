@@ -0,0 +1,329 @@
+#include "sdlpp_font.h"
+
+#include "sdlpp.h"
+
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <stdexcept>
+#include <utility>
+
+namespace sdl {
+
+namespace {
+
+constexpr char32_t replacement_character = 0xFFFD;
+
+class DescriptorLine
+{
+  public:
+    explicit DescriptorLine(std::string_view line) noexcept : line_{line}
+    {
+        tag_ = next_token();
+    }
+
+    [[nodiscard]] std::string_view tag() const noexcept
+    {
+        return tag_;
+    }
+
+    // calls `function(key, value)` for each remaining key=value pair
+    template <typename Function>
+    void for_each_attribute(Function function)
+    {
+        for (auto attribute = next_attribute(); !attribute.first.empty(); attribute = next_attribute()) {
+            function(attribute.first, attribute.second);
+        }
+    }
+
+  private:
+    [[nodiscard]] std::pair<std::string_view, std::string_view> next_attribute() noexcept
+    {
+        const std::string_view token = next_token();
+        const std::size_t equals = token.find('=');
+        if (equals == std::string_view::npos) {
+            return {token, {}};
+        }
+        std::string_view value = token.substr(equals + 1);
+        if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+            value = value.substr(1, value.size() - 2);
+        }
+        return {token.substr(0, equals), value};
+    }
+
+    std::string_view next_token() noexcept
+    {
+        const std::size_t begin = line_.find_first_not_of(" \t\r");
+        if (begin == std::string_view::npos) {
+            line_ = {};
+            return {};
+        }
+        std::size_t end = begin;
+        bool quoted = false;
+        while (end < line_.size() && (quoted || (line_[end] != ' ' && line_[end] != '\t' && line_[end] != '\r'))) {
+            quoted ^= line_[end] == '"';
+            ++end;
+        }
+        const std::string_view token = line_.substr(begin, end - begin);
+        line_.remove_prefix(end);
+        return token;
+    }
+
+    std::string_view line_;
+    std::string_view tag_;
+};
+
+int to_int(std::string_view value)
+{
+    int result = 0;
+    const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), result);
+    if (error != std::errc{} || end != value.data() + value.size()) {
+        throw std::invalid_argument{"malformed number in font descriptor: " + std::string{value}};
+    }
+    return result;
+}
+
+std::string read_file(const std::string& filename)
+{
+    const RWOps file{filename, "rb"};
+    std::string contents(static_cast<std::size_t>(file.size()), '\0');
+    if (!contents.empty()) {
+        static_cast<void>(file.read(1, contents.size(), contents.data()));
+    }
+    return contents;
+}
+
+SDL_Vertex make_vertex(float x, float y, float u, float v) noexcept
+{
+    return SDL_Vertex{{x, y}, {255, 255, 255, 255}, {u, v}};
+}
+
+} // namespace
+
+FontDescriptor parse_bmfont(std::string_view descriptor)
+{
+    FontDescriptor font{};
+    int n_pages = 0;
+    while (!descriptor.empty()) {
+        const std::size_t line_end = descriptor.find('\n');
+        DescriptorLine line{descriptor.substr(0, line_end)};
+        descriptor.remove_prefix(line_end == std::string_view::npos ? descriptor.size() : line_end + 1);
+
+        if (line.tag() == "common") {
+            line.for_each_attribute([&](std::string_view key, std::string_view value) {
+                if (key == "lineHeight") {
+                    font.line_height = to_int(value);
+                } else if (key == "base") {
+                    font.base = to_int(value);
+                } else if (key == "pages") {
+                    n_pages = to_int(value);
+                }
+            });
+        } else if (line.tag() == "page") {
+            line.for_each_attribute([&](std::string_view key, std::string_view value) {
+                if (key == "file") {
+                    font.page_filename = value;
+                }
+            });
+        } else if (line.tag() == "char") {
+            char32_t id = 0;
+            Glyph glyph{};
+            line.for_each_attribute([&](std::string_view key, std::string_view value) {
+                if (key == "id") {
+                    id = static_cast<char32_t>(to_int(value));
+                } else if (key == "x") {
+                    glyph.source.x = to_int(value);
+                } else if (key == "y") {
+                    glyph.source.y = to_int(value);
+                } else if (key == "width") {
+                    glyph.source.w = to_int(value);
+                } else if (key == "height") {
+                    glyph.source.h = to_int(value);
+                } else if (key == "xoffset") {
+                    glyph.offset.x = to_int(value);
+                } else if (key == "yoffset") {
+                    glyph.offset.y = to_int(value);
+                } else if (key == "xadvance") {
+                    glyph.advance = to_int(value);
+                }
+            });
+            font.glyphs[id] = glyph;
+        } else if (line.tag() == "kerning") {
+            char32_t first = 0;
+            char32_t second = 0;
+            int amount = 0;
+            line.for_each_attribute([&](std::string_view key, std::string_view value) {
+                if (key == "first") {
+                    first = static_cast<char32_t>(to_int(value));
+                } else if (key == "second") {
+                    second = static_cast<char32_t>(to_int(value));
+                } else if (key == "amount") {
+                    amount = to_int(value);
+                }
+            });
+            font.kerning[FontDescriptor::kerning_key(first, second)] = amount;
+        }
+    }
+    if (n_pages > 1) {
+        throw std::invalid_argument{"font descriptors with more than one page are not supported"};
+    }
+    return font;
+}
+
+FontDescriptor load_bmfont(const std::string& filename)
+{
+    return parse_bmfont(read_file(filename));
+}
+
+char32_t decode_utf8(std::string_view text, std::size_t& position) noexcept
+{
+    const auto lead = static_cast<unsigned char>(text[position++]);
+    if (lead < 0x80U) {
+        return lead;
+    }
+
+    int n_continuation = 0;
+    char32_t code_point = 0;
+    if ((lead & 0xE0U) == 0xC0U) {
+        n_continuation = 1;
+        code_point = lead & 0x1FU;
+    } else if ((lead & 0xF0U) == 0xE0U) {
+        n_continuation = 2;
+        code_point = lead & 0x0FU;
+    } else if ((lead & 0xF8U) == 0xF0U) {
+        n_continuation = 3;
+        code_point = lead & 0x07U;
+    } else {
+        return replacement_character;
+    }
+
+    for (int i = 0; i < n_continuation; ++i) {
+        if (position >= text.size()) {
+            return replacement_character;
+        }
+        const auto continuation = static_cast<unsigned char>(text[position]);
+        if ((continuation & 0xC0U) != 0x80U) {
+            return replacement_character;
+        }
+        code_point = (code_point << 6U) | (continuation & 0x3FU);
+        ++position;
+    }
+    return code_point;
+}
+
+BitmapFont::BitmapFont(FontDescriptor descriptor, Texture atlas, std::size_t max_cached_layouts)
+    : descriptor_{std::move(descriptor)},
+      atlas_{std::move(atlas)},
+      atlas_size_{static_cast<float>(atlas_.width()), static_cast<float>(atlas_.height())},
+      max_cached_layouts_{max_cached_layouts}
+{}
+
+const TextLayout& BitmapFont::layout(std::string_view text)
+{
+    const auto found = layouts_.find(text);
+    if (found != layouts_.end()) {
+        return found->second;
+    }
+    if (layouts_.size() >= max_cached_layouts_) {
+        layouts_.clear();
+    }
+    return layouts_.emplace(std::string{text}, make_layout(text)).first->second;
+}
+
+void BitmapFont::draw(const Renderer& renderer, std::string_view text, Point<float> position, const Color& color)
+{
+    const TextLayout& text_layout = layout(text);
+    if (text_layout.indices.empty()) {
+        return;
+    }
+    vertices_.resize(text_layout.vertices.size());
+    for (std::size_t i = 0; i < vertices_.size(); ++i) {
+        const SDL_Vertex& vertex = text_layout.vertices[i];
+        vertices_[i] = SDL_Vertex{
+            {vertex.position.x + position.x, vertex.position.y + position.y}, color, vertex.tex_coord
+        };
+    }
+    renderer.render_geometry(atlas_.get_pointer(), vertices_, text_layout.indices);
+}
+
+TextLayout BitmapFont::make_layout(std::string_view text) const
+{
+    TextLayout result{};
+    result.vertices.reserve(4 * text.size());
+    result.indices.reserve(6 * text.size());
+
+    float pen_x = 0.0F;
+    float pen_y = 0.0F;
+    char32_t previous = 0;
+    std::size_t position = 0;
+    while (position < text.size()) {
+        const char32_t code_point = decode_utf8(text, position);
+        if (code_point == U'\n') {
+            result.size.x = std::max(result.size.x, pen_x);
+            pen_x = 0.0F;
+            pen_y += static_cast<float>(descriptor_.line_height);
+            previous = 0;
+            continue;
+        }
+
+        auto glyph = descriptor_.glyphs.find(code_point);
+        if (glyph == descriptor_.glyphs.end()) {
+            glyph = descriptor_.glyphs.find(U'?');
+            if (glyph == descriptor_.glyphs.end()) {
+                continue;
+            }
+        }
+        if (previous != 0) {
+            const auto kerning = descriptor_.kerning.find(FontDescriptor::kerning_key(previous, glyph->first));
+            if (kerning != descriptor_.kerning.end()) {
+                pen_x += static_cast<float>(kerning->second);
+            }
+        }
+        previous = glyph->first;
+
+        const Glyph& metrics = glyph->second;
+        if (metrics.source.w > 0 && metrics.source.h > 0) {
+            const float left = pen_x + static_cast<float>(metrics.offset.x);
+            const float top = pen_y + static_cast<float>(metrics.offset.y);
+            const float right = left + static_cast<float>(metrics.source.w);
+            const float bottom = top + static_cast<float>(metrics.source.h);
+            const float u_left = static_cast<float>(metrics.source.x) / atlas_size_.x;
+            const float v_top = static_cast<float>(metrics.source.y) / atlas_size_.y;
+            const float u_right = static_cast<float>(metrics.source.x + metrics.source.w) / atlas_size_.x;
+            const float v_bottom = static_cast<float>(metrics.source.y + metrics.source.h) / atlas_size_.y;
+
+            const int first = static_cast<int>(result.vertices.size());
+            result.vertices.push_back(make_vertex(left, top, u_left, v_top));
+            result.vertices.push_back(make_vertex(right, top, u_right, v_top));
+            result.vertices.push_back(make_vertex(right, bottom, u_right, v_bottom));
+            result.vertices.push_back(make_vertex(left, bottom, u_left, v_bottom));
+            for (const int corner : {0, 1, 2, 0, 2, 3}) {
+                result.indices.push_back(first + corner);
+            }
+        }
+        pen_x += static_cast<float>(metrics.advance);
+    }
+    result.size.x = std::max(result.size.x, pen_x);
+    result.size.y = pen_y + static_cast<float>(descriptor_.line_height);
+    return result;
+}
+
+BitmapFont load_bitmap_font(const Renderer& renderer, const std::string& filename)
+{
+    return load_bitmap_font(renderer, filename, [](const std::string& page) { return load_bmp(page); });
+}
+
+BitmapFont load_bitmap_font(
+    const Renderer& renderer,
+    const std::string& filename,
+    const std::function<SurfaceUniquePtr(const std::string&)>& load_page
+)
+{
+    FontDescriptor descriptor = load_bmfont(filename);
+    const std::filesystem::path page = std::filesystem::path{filename}.parent_path() / descriptor.page_filename;
+    SurfaceUniquePtr surface = load_page(page.string());
+    Texture atlas{renderer.make_texture_from_surface(surface.get())};
+    return BitmapFont{std::move(descriptor), std::move(atlas)};
+}
+
+} // namespace sdl
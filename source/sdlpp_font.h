@@ -0,0 +1,110 @@
+#pragma once
+
+#include "sdlpp.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace sdl {
+
+struct Glyph
+{
+    Rectangle<int> source;
+    Point<int> offset;
+    int advance;
+};
+
+// Contents of an AngelCode BMFont text descriptor (.fnt) with a single page.
+struct FontDescriptor
+{
+    int line_height;
+    int base;
+    std::string page_filename;
+    std::unordered_map<char32_t, Glyph> glyphs;
+    // keyed by kerning_key(first, second)
+    std::unordered_map<std::uint64_t, int> kerning;
+
+    [[nodiscard]] static constexpr std::uint64_t kerning_key(char32_t first, char32_t second) noexcept
+    {
+        return (static_cast<std::uint64_t>(first) << 32U) | static_cast<std::uint64_t>(second);
+    }
+};
+
+[[nodiscard]] FontDescriptor parse_bmfont(std::string_view descriptor);
+[[nodiscard]] FontDescriptor load_bmfont(const std::string& filename);
+
+// decodes the code point starting at `position` and advances past it; malformed sequences yield U+FFFD
+[[nodiscard]] char32_t decode_utf8(std::string_view text, std::size_t& position) noexcept;
+
+// Glyph quads for one string in font-local coordinates, ready to be drawn with a single SDL_RenderGeometry call.
+struct TextLayout
+{
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices;
+    Point<float> size;
+};
+
+// Bitmap font drawing from one atlas texture. Layouts are cached per string, so redrawing unchanged text only
+// offsets and tints the cached quads.
+class BitmapFont
+{
+  public:
+    BitmapFont(FontDescriptor descriptor, Texture atlas, std::size_t max_cached_layouts = 256);
+
+    // returns the cached layout of `text`, laying it out first if needed; invalidated by later calls
+    [[nodiscard]] const TextLayout& layout(std::string_view text);
+
+    [[nodiscard]] Point<float> measure(std::string_view text)
+    {
+        return layout(text).size;
+    }
+
+    void draw(const Renderer& renderer, std::string_view text, Point<float> position, const Color& color);
+
+    [[nodiscard]] const FontDescriptor& descriptor() const noexcept
+    {
+        return descriptor_;
+    }
+
+    [[nodiscard]] const Texture& atlas() const noexcept
+    {
+        return atlas_;
+    }
+
+  private:
+    // lets the layout cache be searched with a string_view, so hits allocate no key
+    struct TextHash
+    {
+        using is_transparent = void;
+
+        [[nodiscard]] std::size_t operator()(std::string_view text) const noexcept
+        {
+            return std::hash<std::string_view>{}(text);
+        }
+    };
+
+    [[nodiscard]] TextLayout make_layout(std::string_view text) const;
+
+    FontDescriptor descriptor_;
+    Texture atlas_;
+    Point<float> atlas_size_;
+    std::size_t max_cached_layouts_;
+    std::unordered_map<std::string, TextLayout, TextHash, std::equal_to<>> layouts_;
+    std::vector<SDL_Vertex> vertices_;
+};
+
+// loads a BMFont descriptor and its page, resolved relative to the descriptor, with load_bmp
+[[nodiscard]] BitmapFont load_bitmap_font(const Renderer& renderer, const std::string& filename);
+// as load_bitmap_font, loading the page with `load_page`, e.g. to read formats other than BMP
+[[nodiscard]] BitmapFont load_bitmap_font(
+    const Renderer& renderer,
+    const std::string& filename,
+    const std::function<SurfaceUniquePtr(const std::string&)>& load_page
+);
+
+} // namespace sdl
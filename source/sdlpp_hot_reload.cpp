@@ -0,0 +1,410 @@
+#include "sdlpp_hot_reload.h"
+
+#include "sdlpp.h"
+#include "sdlpp_image.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <iterator>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#define SDLWRAP_HAVE_INOTIFY 1
+#endif
+
+namespace sdl::image {
+
+namespace {
+
+// upper bound on one wait of the watcher thread, and so on how long destruction waits for it
+constexpr std::chrono::milliseconds max_wait{100};
+
+struct PixelLayout
+{
+    int pitch;
+    std::size_t size;
+};
+
+PixelLayout pixel_layout(Uint32 format, int width, int height)
+{
+    const auto rows = static_cast<std::size_t>(height);
+    switch (format) {
+    case SDL_PIXELFORMAT_YUY2:
+    case SDL_PIXELFORMAT_UYVY:
+    case SDL_PIXELFORMAT_YVYU: {
+        // packed 4:2:2, four bytes per pair of pixels
+        const int pitch = (width + 1) / 2 * 4;
+        return {pitch, static_cast<std::size_t>(pitch) * rows};
+    }
+    case SDL_PIXELFORMAT_YV12:
+    case SDL_PIXELFORMAT_IYUV:
+    case SDL_PIXELFORMAT_NV12:
+    case SDL_PIXELFORMAT_NV21:
+        // a full resolution luma plane followed by quarter resolution chroma
+        return {
+            width,
+            static_cast<std::size_t>(width) * rows +
+                2 * static_cast<std::size_t>((width + 1) / 2) * static_cast<std::size_t>((height + 1) / 2),
+        };
+    default: {
+        const int pitch = width * static_cast<int>(SDL_BYTESPERPIXEL(format));
+        return {pitch, static_cast<std::size_t>(pitch) * rows};
+    }
+    }
+}
+
+// writes `surface` to `texture` of `format`, converting the pixels first when the formats differ
+void upload(SDL_Texture* texture, Uint32 format, SDL_Surface& surface)
+{
+    if (SDL_MUSTLOCK(&surface) && SDL_LockSurface(&surface) != 0) {
+        throw GenericError{};
+    }
+    int status = 0;
+    if (surface.format->format == format) {
+        status = SDL_UpdateTexture(texture, nullptr, surface.pixels, surface.pitch);
+    } else {
+        // a YUV texture, which surfaces cannot hold, or one watched along with a texture of another format
+        const PixelLayout layout = pixel_layout(format, surface.w, surface.h);
+        std::vector<Uint8> pixels(layout.size);
+        status = SDL_ConvertPixels(
+            surface.w,
+            surface.h,
+            surface.format->format,
+            surface.pixels,
+            surface.pitch,
+            format,
+            pixels.data(),
+            layout.pitch
+        );
+        if (status == 0) {
+            status = SDL_UpdateTexture(texture, nullptr, pixels.data(), layout.pitch);
+        }
+    }
+    if (SDL_MUSTLOCK(&surface)) {
+        SDL_UnlockSurface(&surface);
+    }
+    if (status != 0) {
+        throw GenericError{};
+    }
+}
+
+// gives `destination` the blend mode, scale mode and color and alpha modulation of `source`
+void copy_texture_state(SDL_Texture* source, SDL_Texture* destination)
+{
+    SDL_BlendMode blend_mode = SDL_BLENDMODE_NONE;
+    SDL_ScaleMode scale_mode = SDL_ScaleModeNearest;
+    Color modulation;
+    if (SDL_GetTextureBlendMode(source, &blend_mode) != 0 || SDL_GetTextureScaleMode(source, &scale_mode) != 0 ||
+        SDL_GetTextureColorMod(source, &modulation.r, &modulation.g, &modulation.b) != 0 ||
+        SDL_GetTextureAlphaMod(source, &modulation.a) != 0) {
+        throw GenericError{};
+    }
+    if (SDL_SetTextureBlendMode(destination, blend_mode) != 0 ||
+        SDL_SetTextureScaleMode(destination, scale_mode) != 0 ||
+        SDL_SetTextureColorMod(destination, modulation.r, modulation.g, modulation.b) != 0 ||
+        SDL_SetTextureAlphaMod(destination, modulation.a) != 0) {
+        throw GenericError{};
+    }
+}
+
+void reload_texture(const Renderer& renderer, Texture& texture, SDL_Surface& surface)
+{
+    const Texture::Properties properties = texture.properties();
+    if (properties.width == surface.w && properties.height == surface.h) {
+        upload(texture.get_pointer(), properties.format, surface);
+        return;
+    }
+
+    // the size is fixed at creation, so only a resized image replaces the SDL_Texture
+    TextureUniquePtr replacement = renderer.make_texture(properties.format, properties.access, surface.w, surface.h);
+    copy_texture_state(texture.get_pointer(), replacement.get());
+    upload(replacement.get(), properties.format, surface);
+    texture = Texture{std::move(replacement)};
+}
+
+} // namespace
+
+HotReloader::HotReloader(HotReloadConfig config) : config_{std::move(config)}
+{
+#ifdef SDLWRAP_HAVE_INOTIFY
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ < 0) {
+        throw std::system_error{errno, std::generic_category(), "inotify_init1"};
+    }
+    try {
+        for (const std::string& directory : config_.directories) {
+            add_directory(std::filesystem::weakly_canonical(directory), true);
+        }
+    } catch (...) {
+        close(inotify_fd_);
+        throw;
+    }
+#endif
+    watcher_ = std::thread{&HotReloader::run, this};
+}
+
+HotReloader::~HotReloader()
+{
+    stopping_ = true;
+    watcher_.join();
+#ifdef SDLWRAP_HAVE_INOTIFY
+    close(inotify_fd_);
+#endif
+}
+
+void HotReloader::watch(const std::string& filename, Texture& texture)
+{
+    if (texture.get_pointer() == nullptr) {
+        throw std::invalid_argument{"cannot watch an empty texture"};
+    }
+    const std::filesystem::path path = std::filesystem::weakly_canonical(filename);
+    std::error_code error;
+    const std::filesystem::file_time_type modified = std::filesystem::last_write_time(path, error);
+
+    const std::scoped_lock lock{mutex_};
+    files_.try_emplace(path, WatchedFile{{}, texture.format(), modified}).first->second.textures.push_back(&texture);
+}
+
+void HotReloader::unwatch(const Texture& texture)
+{
+    const std::scoped_lock lock{mutex_};
+    for (auto file = files_.begin(); file != files_.end();) {
+        std::erase(file->second.textures, &texture);
+        file = file->second.textures.empty() ? files_.erase(file) : std::next(file);
+    }
+}
+
+std::size_t HotReloader::apply(const Renderer& renderer)
+{
+    std::vector<Reload> reloads;
+    {
+        const std::scoped_lock lock{mutex_};
+        if (error_) {
+            std::rethrow_exception(std::exchange(error_, nullptr));
+        }
+        reloads.swap(reloads_);
+    }
+
+    std::size_t n_updated = 0;
+    for (Reload& reload : reloads) {
+        std::vector<Texture*> textures;
+        {
+            const std::scoped_lock lock{mutex_};
+            const auto found = files_.find(reload.path);
+            if (found == files_.end()) {
+                continue;
+            }
+            textures = found->second.textures;
+        }
+        for (Texture* texture : textures) {
+            reload_texture(renderer, *texture, *reload.surface);
+            ++n_updated;
+        }
+
+        const std::scoped_lock lock{mutex_};
+        n_reloaded_ += textures.size();
+    }
+    return n_updated;
+}
+
+std::size_t HotReloader::n_reloaded() const
+{
+    const std::scoped_lock lock{mutex_};
+    return n_reloaded_;
+}
+
+std::size_t HotReloader::n_failed() const
+{
+    const std::scoped_lock lock{mutex_};
+    return n_failed_;
+}
+
+void HotReloader::run()
+{
+    try {
+        while (!stopping_) {
+            detect_changes(std::chrono::steady_clock::now());
+
+            const auto now = std::chrono::steady_clock::now();
+            for (auto pending = pending_.begin(); pending != pending_.end();) {
+                if (pending->second <= now) {
+                    decode(pending->first);
+                    pending = pending_.erase(pending);
+                } else {
+                    ++pending;
+                }
+            }
+        }
+    } catch (...) {
+        const std::scoped_lock lock{mutex_};
+        if (!error_) {
+            error_ = std::current_exception();
+        }
+    }
+}
+
+void HotReloader::detect_changes(std::chrono::steady_clock::time_point now)
+{
+    auto wait = max_wait;
+    for (const auto& [path, deadline] : pending_) {
+        const auto remaining = std::max(deadline - now, std::chrono::steady_clock::duration::zero());
+        wait = std::min(wait, std::chrono::ceil<std::chrono::milliseconds>(remaining));
+    }
+
+#ifdef SDLWRAP_HAVE_INOTIFY
+    pollfd descriptor{inotify_fd_, POLLIN, 0};
+    if (poll(&descriptor, 1, static_cast<int>(wait.count())) < 0) {
+        if (errno == EINTR) {
+            return;
+        }
+        throw std::system_error{errno, std::generic_category(), "poll"};
+    }
+
+    alignas(inotify_event) char buffer[4096];
+    while (true) {
+        const ssize_t length = read(inotify_fd_, buffer, sizeof(buffer));
+        if (length < 0) {
+            if (errno == EAGAIN || errno == EINTR) {
+                return;
+            }
+            throw std::system_error{errno, std::generic_category(), "read inotify events"};
+        }
+        const auto event_time = std::chrono::steady_clock::now();
+        for (const char* position = buffer; position < buffer + length;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(position);
+            position += sizeof(inotify_event) + event->len;
+
+            if ((event->mask & IN_Q_OVERFLOW) != 0) {
+                // events were lost; reload everything rather than miss a change
+                const std::scoped_lock lock{mutex_};
+                for (const auto& [path, file] : files_) {
+                    pending_[path] = event_time + config_.debounce;
+                }
+                continue;
+            }
+            if ((event->mask & IN_IGNORED) != 0) {
+                watch_directories_.erase(event->wd);
+                continue;
+            }
+            const auto directory = watch_directories_.find(event->wd);
+            if (directory == watch_directories_.end() || event->len == 0) {
+                continue;
+            }
+            const std::filesystem::path path = directory->second / event->name;
+            if ((event->mask & IN_ISDIR) != 0) {
+                std::error_code error;
+                if (std::filesystem::is_directory(path, error)) {
+                    add_directory(path, false);
+                    // watched files may have been written below it before its watch was in place
+                    const std::scoped_lock lock{mutex_};
+                    for (const auto& [file_path, file] : files_) {
+                        if (std::mismatch(path.begin(), path.end(), file_path.begin(), file_path.end()).first ==
+                            path.end()) {
+                            pending_[file_path] = event_time + config_.debounce;
+                        }
+                    }
+                }
+                continue;
+            }
+            if ((event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) != 0) {
+                const std::scoped_lock lock{mutex_};
+                if (files_.contains(path)) {
+                    // every further write pushes the reload back
+                    pending_[path] = event_time + config_.debounce;
+                }
+            }
+        }
+    }
+#else
+    std::this_thread::sleep_for(std::min(wait, config_.poll_interval));
+    now = std::chrono::steady_clock::now();
+    if (now < next_poll_) {
+        return;
+    }
+    next_poll_ = now + config_.poll_interval;
+
+    const std::scoped_lock lock{mutex_};
+    for (auto& [path, file] : files_) {
+        std::error_code error;
+        const std::filesystem::file_time_type modified = std::filesystem::last_write_time(path, error);
+        if (!error && modified != file.modified) {
+            file.modified = modified;
+            pending_[path] = now + config_.debounce;
+        }
+    }
+#endif
+}
+
+void HotReloader::add_directory(const std::filesystem::path& directory, bool initial)
+{
+#ifdef SDLWRAP_HAVE_INOTIFY
+    // Past the constructor, directories are added as they appear, and temporary ones often vanish again before they
+    // are watched or listed. Those, and any other directory that cannot be watched then, are skipped rather than
+    // stopping the watcher thread.
+    constexpr Uint32 mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR;
+    const int descriptor = inotify_add_watch(inotify_fd_, directory.c_str(), mask);
+    if (descriptor < 0) {
+        if (!initial) {
+            return;
+        }
+        throw std::system_error{errno, std::generic_category(), "inotify_add_watch " + directory.string()};
+    }
+    watch_directories_[descriptor] = directory;
+
+    std::error_code error;
+    for (std::filesystem::directory_iterator entry{directory, error};
+         !error && entry != std::filesystem::directory_iterator{};
+         entry.increment(error)) {
+        std::error_code status_error;
+        if (entry->is_directory(status_error) && !entry->is_symlink(status_error)) {
+            add_directory(entry->path(), initial);
+        }
+    }
+    if (error && initial) {
+        throw std::filesystem::filesystem_error{"list watched directory", directory, error};
+    }
+#else
+    static_cast<void>(directory);
+    static_cast<void>(initial);
+#endif
+}
+
+void HotReloader::decode(const std::filesystem::path& path)
+{
+    Uint32 format = SDL_PIXELFORMAT_UNKNOWN;
+    {
+        const std::scoped_lock lock{mutex_};
+        const auto found = files_.find(path);
+        if (found == files_.end()) {
+            return;
+        }
+        format = found->second.format;
+    }
+
+    SurfaceUniquePtr surface;
+    try {
+        surface = load_image(path.string());
+        // surfaces cannot hold YUV formats; apply() converts to those from ARGB8888
+        const Uint32 surface_format = SDL_ISPIXELFORMAT_FOURCC(format) ? Uint32{SDL_PIXELFORMAT_ARGB8888} : format;
+        if (surface->format->format != surface_format) {
+            surface = convert_surface_format(std::move(surface), surface_format);
+        }
+    } catch (const std::exception&) {
+        const std::scoped_lock lock{mutex_};
+        ++n_failed_;
+        return;
+    }
+
+    const std::scoped_lock lock{mutex_};
+    // a reload apply() has not picked up yet is superseded
+    std::erase_if(reloads_, [&path](const Reload& reload) { return reload.path == path; });
+    reloads_.push_back(Reload{path, std::move(surface)});
+}
+
+} // namespace sdl::image
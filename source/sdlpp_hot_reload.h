@@ -0,0 +1,95 @@
+#pragma once
+
+#include "sdlpp.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace sdl::image {
+
+struct HotReloadConfig
+{
+    // watched recursively; directories created later below them are picked up as well
+    std::vector<std::string> directories;
+    // a file is reloaded once it has not been written to for this long, so a burst of writes costs one reload
+    std::chrono::milliseconds debounce{250};
+    // how often modification times are compared on platforms without inotify
+    std::chrono::milliseconds poll_interval{500};
+};
+
+// Reloads watched textures when their files change on disk. Changes are detected with inotify on Linux and by polling
+// modification times elsewhere; changed files are decoded and converted to their texture's format on a background
+// thread. apply() then updates each texture in place. Only when an image's dimensions changed is its texture recreated,
+// keeping its format, access, blend and scale modes and modulation; the Texture objects held by the game stay valid,
+// but the old SDL_Texture is destroyed, so raw pointers to it, such as those from get_pointer() or passed to
+// Tilemap::add_tile, must be fetched again after apply().
+class HotReloader
+{
+  public:
+    explicit HotReloader(HotReloadConfig config);
+    HotReloader(const HotReloader&) = delete;
+    HotReloader& operator=(const HotReloader&) = delete;
+    ~HotReloader();
+
+    // reloads `texture`, which must not be empty, from `filename` on every change; the texture must stay alive until
+    // unwatched
+    void watch(const std::string& filename, Texture& texture);
+    void unwatch(const Texture& texture);
+
+    // uploads every reload decoded since the last call and returns the number of textures updated; call it on the
+    // rendering thread. Rethrows the first error of the watcher thread.
+    std::size_t apply(const Renderer& renderer);
+
+    [[nodiscard]] std::size_t n_reloaded() const;
+    // changes whose file could not be decoded, e.g. because it was still incomplete
+    [[nodiscard]] std::size_t n_failed() const;
+
+  private:
+    struct WatchedFile
+    {
+        std::vector<Texture*> textures;
+        // the format decoded pixels are converted to, taken from the first texture
+        Uint32 format;
+        std::filesystem::file_time_type modified;
+    };
+
+    struct Reload
+    {
+        std::filesystem::path path;
+        SurfaceUniquePtr surface;
+    };
+
+    void run();
+    void detect_changes(std::chrono::steady_clock::time_point now);
+    // `initial` while the constructor sets up the configured directories; only then are failures thrown
+    void add_directory(const std::filesystem::path& directory, bool initial);
+    void decode(const std::filesystem::path& path);
+
+    HotReloadConfig config_;
+
+    mutable std::mutex mutex_;
+    std::map<std::filesystem::path, WatchedFile> files_;
+    std::vector<Reload> reloads_;
+    std::size_t n_reloaded_{0};
+    std::size_t n_failed_{0};
+    std::exception_ptr error_;
+
+    // touched only by the watcher thread, and by the constructor before it starts
+    int inotify_fd_{-1};
+    std::map<int, std::filesystem::path> watch_directories_;
+    std::map<std::filesystem::path, std::chrono::steady_clock::time_point> pending_;
+    std::chrono::steady_clock::time_point next_poll_;
+
+    std::atomic<bool> stopping_{false};
+    std::thread watcher_;
+};
+
+} // namespace sdl::image
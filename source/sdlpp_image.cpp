@@ -1,43 +1,100 @@
 #include "sdlpp_image.h"
 
 #include "sdlpp.h"
+#include "sdlpp_font.h"
+#include "sdlpp_mipmap.h"
 
+#include <future>
 #include <string>
 #include <string_view>
+#include <utility>
 
 namespace sdl::image {
 
-SurfaceUniquePtr load_image(const std::string& filename)
+SurfaceUniquePtr load_image(const std::string& filename SDLWRAP_SITE_DEFINITION)
 {
     SurfaceUniquePtr image{IMG_Load(filename.c_str())};
     if (image == nullptr) {
         throw generic_error{};
     }
+    SDLWRAP_TRACK(accounting::ResourceType::surface, image.get(), accounting::estimate_bytes(image.get()));
     return image;
 }
 
-SurfaceUniquePtr load_sized_svg_rw(SDL_RWops* source, const int width, const int height)
+SurfaceUniquePtr load_sized_svg_rw(SDL_RWops* source, const int width, const int height SDLWRAP_SITE_DEFINITION)
 {
     SurfaceUniquePtr image{IMG_LoadSizedSVG_RW(source, width, height)};
     if (image == nullptr) {
         throw generic_error{};
     }
+    SDLWRAP_TRACK(accounting::ResourceType::surface, image.get(), accounting::estimate_bytes(image.get()));
     return image;
 }
 
-SurfaceUniquePtr load_sized_svg_rw(SDL_RWops* source, const Point<int> size)
+SurfaceUniquePtr load_sized_svg_rw(SDL_RWops* source, const Point<int> size SDLWRAP_SITE_DEFINITION)
 {
-    return load_sized_svg_rw(source, size.x, size.y);
+    return load_sized_svg_rw(source, size.x, size.y SDLWRAP_SITE_ARGUMENT);
 }
 
-SurfaceUniquePtr load_sized_svg(const std::string& filename, const int width, const int height)
+SurfaceUniquePtr load_sized_svg(const std::string& filename, const int width, const int height SDLWRAP_SITE_DEFINITION)
 {
-    return load_sized_svg_rw(rw_from_file(filename, "r").get(), width, height);
+    return load_sized_svg_rw(rw_from_file(filename, "r").get(), width, height SDLWRAP_SITE_ARGUMENT);
 }
 
-SurfaceUniquePtr load_sized_svg(const std::string& filename, const Point<int> size)
+SurfaceUniquePtr load_sized_svg(const std::string& filename, const Point<int> size SDLWRAP_SITE_DEFINITION)
 {
-    return load_sized_svg(filename, size.x, size.y);
+    return load_sized_svg(filename, size.x, size.y SDLWRAP_SITE_ARGUMENT);
+}
+
+NativeSurface load_native_image(const std::string& filename, const SDL_RendererInfo& info)
+{
+    return convert_to_native_surface(load_image(filename), info);
+}
+
+std::future<NativeSurface> load_native_image_async(std::string filename, const SDL_RendererInfo& info)
+{
+    return std::async(std::launch::async, [filename = std::move(filename), info] {
+        return load_native_image(filename, info);
+    });
+}
+
+MipmappedImage load_mipmapped_image(const std::string& filename)
+{
+    return load_mipmapped_image(filename, MipmapConfig{});
+}
+
+MipmappedImage load_mipmapped_image(const std::string& filename, const MipmapConfig& config)
+{
+    return MipmappedImage{load_image(filename), config};
+}
+
+std::future<MipmappedImage> load_mipmapped_image_async(std::string filename)
+{
+    return load_mipmapped_image_async(std::move(filename), MipmapConfig{});
+}
+
+std::future<MipmappedImage> load_mipmapped_image_async(std::string filename, const MipmapConfig& config)
+{
+    return std::async(std::launch::async, [filename = std::move(filename), config] {
+        return load_mipmapped_image(filename, config);
+    });
+}
+
+BitmapFont load_bitmap_font(const Renderer& renderer, const std::string& filename)
+{
+    return sdl::load_bitmap_font(renderer, filename, [](const std::string& page) { return load_image(page); });
+}
+
+void save_png_rw(SDL_Surface* surface, SDL_RWops* destination)
+{
+    if (IMG_SavePNG_RW(surface, destination, 0) != 0) {
+        throw generic_error{};
+    }
+}
+
+void save_png(SDL_Surface* surface, const std::string& filename)
+{
+    save_png_rw(surface, rw_from_file(filename, "wb").get());
 }
 
 } // namespace sdl::image
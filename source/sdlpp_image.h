@@ -4,7 +4,18 @@
 
 #include "SDL_image.h"
 
+#include <future>
 #include <stdexcept>
+#include <string>
+
+namespace sdl {
+
+// include sdlpp_font.h or sdlpp_mipmap.h to use the loaders returning these
+class BitmapFont;
+class MipmappedImage;
+struct MipmapConfig;
+
+} // namespace sdl
 
 namespace sdl::image {
 
@@ -36,10 +47,30 @@ inline void quit()
     IMG_Quit();
 }
 
-[[nodiscard]] SurfaceUniquePtr load_image(const std::string& filename);
-[[nodiscard]] SurfaceUniquePtr load_sized_svg_rw(SDL_RWops* source, int width, int height);
-[[nodiscard]] SurfaceUniquePtr load_sized_svg_rw(SDL_RWops* source, Point<int> size);
-[[nodiscard]] SurfaceUniquePtr load_sized_svg(const std::string& filename, int width, int height);
-[[nodiscard]] SurfaceUniquePtr load_sized_svg(const std::string& filename, Point<int> size);
+[[nodiscard]] SurfaceUniquePtr load_image(const std::string& filename SDLWRAP_SITE_PARAMETER);
+[[nodiscard]] SurfaceUniquePtr load_sized_svg_rw(SDL_RWops* source, int width, int height SDLWRAP_SITE_PARAMETER);
+[[nodiscard]] SurfaceUniquePtr load_sized_svg_rw(SDL_RWops* source, Point<int> size SDLWRAP_SITE_PARAMETER);
+[[nodiscard]] SurfaceUniquePtr
+load_sized_svg(const std::string& filename, int width, int height SDLWRAP_SITE_PARAMETER);
+[[nodiscard]] SurfaceUniquePtr load_sized_svg(const std::string& filename, Point<int> size SDLWRAP_SITE_PARAMETER);
+
+// decodes `filename` and converts it once to the format `info`'s renderer stores natively, so creating the texture
+// with Renderer::make_texture_from_native_surface and later updates are plain copies
+[[nodiscard]] NativeSurface load_native_image(const std::string& filename, const SDL_RendererInfo& info);
+// as load_native_image, decoding and converting on a background thread
+[[nodiscard]] std::future<NativeSurface> load_native_image_async(std::string filename, const SDL_RendererInfo& info);
+
+// decodes `filename` and builds its mip chain, for images drawn smaller than their full size
+[[nodiscard]] MipmappedImage load_mipmapped_image(const std::string& filename);
+[[nodiscard]] MipmappedImage load_mipmapped_image(const std::string& filename, const MipmapConfig& config);
+// as load_mipmapped_image, decoding and downscaling on a background thread; textures are still uploaded on first draw
+[[nodiscard]] std::future<MipmappedImage> load_mipmapped_image_async(std::string filename);
+[[nodiscard]] std::future<MipmappedImage> load_mipmapped_image_async(std::string filename, const MipmapConfig& config);
+
+// loads a BMFont descriptor and its page, resolved relative to the descriptor, in any format load_image supports
+[[nodiscard]] BitmapFont load_bitmap_font(const Renderer& renderer, const std::string& filename);
+
+void save_png_rw(SDL_Surface* surface, SDL_RWops* destination);
+void save_png(SDL_Surface* surface, const std::string& filename);
 
 } // namespace sdl::image
@@ -0,0 +1,149 @@
+#include "sdlpp_input.h"
+
+#include "sdlpp.h"
+
+#include <algorithm>
+
+namespace sdl {
+
+InputFrame::InputFrame(
+    const InputSnapshot& snapshot, InputTick previous_tick, Point<int> previous_motion_total,
+    Point<int> previous_wheel_total
+) noexcept
+    : snapshot_{&snapshot},
+      previous_tick_{previous_tick},
+      mouse_motion_{
+          snapshot.mouse_motion_total.x - previous_motion_total.x,
+          snapshot.mouse_motion_total.y - previous_motion_total.y
+      },
+      mouse_wheel_{
+          snapshot.mouse_wheel_total.x - previous_wheel_total.x, snapshot.mouse_wheel_total.y - previous_wheel_total.y
+      }
+{}
+
+InputTracker::InputTracker() noexcept
+{
+    // the first tick is 1 so that edges stamped 0 never count as new
+    state_.tick = 1;
+}
+
+void InputTracker::handle_event(const Event& event)
+{
+    const InputTick tick = state_.tick;
+    switch (event.type) {
+    case SDL_KEYDOWN:
+        if (event.key.repeat == 0) {
+            state_.keys.press(event.key.keysym.scancode, tick);
+        }
+        break;
+    case SDL_KEYUP:
+        state_.keys.release(event.key.keysym.scancode, tick);
+        break;
+    case SDL_MOUSEMOTION:
+        state_.mouse_position = {event.motion.x, event.motion.y};
+        state_.mouse_motion_total.x += event.motion.xrel;
+        state_.mouse_motion_total.y += event.motion.yrel;
+        break;
+    case SDL_MOUSEBUTTONDOWN:
+        state_.mouse_buttons.press(event.button.button, tick);
+        break;
+    case SDL_MOUSEBUTTONUP:
+        state_.mouse_buttons.release(event.button.button, tick);
+        break;
+    case SDL_MOUSEWHEEL: {
+        const int direction = event.wheel.direction == SDL_MOUSEWHEEL_FLIPPED ? -1 : 1;
+        state_.mouse_wheel_total.x += direction * event.wheel.x;
+        state_.mouse_wheel_total.y += direction * event.wheel.y;
+        break;
+    }
+    case SDL_CONTROLLERDEVICEADDED:
+        add_controller(event.cdevice.which);
+        break;
+    case SDL_CONTROLLERDEVICEREMOVED:
+        remove_controller(event.cdevice.which);
+        break;
+    case SDL_CONTROLLERBUTTONDOWN:
+        if (ControllerState* const controller = find_controller(event.cbutton.which)) {
+            controller->buttons.press(event.cbutton.button, tick);
+        }
+        break;
+    case SDL_CONTROLLERBUTTONUP:
+        if (ControllerState* const controller = find_controller(event.cbutton.which)) {
+            controller->buttons.release(event.cbutton.button, tick);
+        }
+        break;
+    case SDL_CONTROLLERAXISMOTION:
+        if (ControllerState* const controller = find_controller(event.caxis.which);
+            controller != nullptr && event.caxis.axis < controller->axes.size()) {
+            controller->axes[event.caxis.axis] = event.caxis.value;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void InputTracker::publish() noexcept
+{
+    snapshots_.back() = state_;
+    snapshots_.publish();
+    ++state_.tick;
+}
+
+InputFrame InputTracker::read() noexcept
+{
+    const InputSnapshot& snapshot = snapshots_.acquire();
+    const InputFrame frame{snapshot, previous_tick_, previous_motion_total_, previous_wheel_total_};
+    previous_tick_ = snapshot.tick;
+    previous_motion_total_ = snapshot.mouse_motion_total;
+    previous_wheel_total_ = snapshot.mouse_wheel_total;
+    return frame;
+}
+
+void InputTracker::add_controller(int device_index)
+{
+    const auto free_slot = std::find(controllers_.begin(), controllers_.end(), nullptr);
+    if (free_slot == controllers_.end()) {
+        return;
+    }
+    GameControllerUniquePtr controller{SDL_GameControllerOpen(device_index)};
+    if (controller == nullptr) {
+        throw GenericError{};
+    }
+    const SDL_JoystickID id = SDL_JoystickInstanceID(SDL_GameControllerGetJoystick(controller.get()));
+    // SDL reports controllers attached at startup again once they are opened
+    if (find_controller(id) != nullptr) {
+        return;
+    }
+
+    ControllerState& state = state_.controllers[static_cast<std::size_t>(free_slot - controllers_.begin())];
+    state.id = id;
+    state.axes.fill(0);
+    *free_slot = std::move(controller);
+}
+
+void InputTracker::remove_controller(SDL_JoystickID id) noexcept
+{
+    ControllerState* const state = find_controller(id);
+    if (state == nullptr) {
+        return;
+    }
+    // a controller unplugged with buttons held reports them released
+    state->buttons.release_all(state_.tick);
+    state->axes.fill(0);
+    state->id = -1;
+    controllers_[static_cast<std::size_t>(state - state_.controllers.data())].reset();
+}
+
+ControllerState* InputTracker::find_controller(SDL_JoystickID id) noexcept
+{
+    if (id < 0) {
+        return nullptr;
+    }
+    const auto found = std::find_if(state_.controllers.begin(), state_.controllers.end(), [id](const auto& controller) {
+        return controller.id == id;
+    });
+    return found == state_.controllers.end() ? nullptr : &*found;
+}
+
+} // namespace sdl
@@ -0,0 +1,254 @@
+#pragma once
+
+#include "sdlpp.h"
+
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace sdl {
+
+// Lock-free triple buffer for one writer and one reader. The writer fills back() and publishes it; the reader
+// acquires the most recently published value. Both sides only swap slot indices, so neither ever waits or copies.
+template <typename T>
+class TripleBuffer
+{
+  public:
+    // writer side
+    [[nodiscard]] T& back() noexcept
+    {
+        return slots_[back_];
+    }
+
+    void publish() noexcept
+    {
+        back_ = middle_.exchange(back_ | fresh_bit, std::memory_order_acq_rel) & index_mask;
+    }
+
+    // reader side; the returned value stays valid and unchanged until the next acquire
+    [[nodiscard]] const T& acquire() noexcept
+    {
+        if ((middle_.load(std::memory_order_relaxed) & fresh_bit) != 0) {
+            front_ = middle_.exchange(front_, std::memory_order_acq_rel) & index_mask;
+        }
+        return slots_[front_];
+    }
+
+  private:
+    static constexpr std::uint8_t index_mask = 0x3;
+    static constexpr std::uint8_t fresh_bit = 0x4;
+
+    std::array<T, 3> slots_{};
+    // touched only by the writer
+    std::uint8_t back_{0};
+    // touched only by the reader
+    alignas(64) std::uint8_t front_{1};
+    alignas(64) std::atomic<std::uint8_t> middle_{2};
+};
+
+// Ticks count published snapshots, starting at 1; 0 means "never".
+using InputTick = std::uint32_t;
+
+template <std::size_t N>
+struct ButtonSet
+{
+    std::bitset<N> down;
+    // tick of the most recent press and release of each button
+    std::array<InputTick, N> pressed_at{};
+    std::array<InputTick, N> released_at{};
+
+    void press(std::size_t button, InputTick tick) noexcept
+    {
+        if (button < N && !down[button]) {
+            down[button] = true;
+            pressed_at[button] = tick;
+        }
+    }
+
+    void release(std::size_t button, InputTick tick) noexcept
+    {
+        if (button < N && down[button]) {
+            down[button] = false;
+            released_at[button] = tick;
+        }
+    }
+
+    void release_all(InputTick tick) noexcept
+    {
+        for (std::size_t button = 0; button < N; ++button) {
+            release(button, tick);
+        }
+    }
+};
+
+struct ControllerState
+{
+    // -1 while the slot is free
+    SDL_JoystickID id{-1};
+    ButtonSet<SDL_CONTROLLER_BUTTON_MAX> buttons;
+    std::array<Sint16, SDL_CONTROLLER_AXIS_MAX> axes{};
+
+    [[nodiscard]] bool connected() const noexcept
+    {
+        return id >= 0;
+    }
+};
+
+// Input state as of the end of one tick. Edges are stored as the tick they happened in, and mouse motion and wheel
+// as running totals, so a reader that skips snapshots still sees every transition since the last one it read.
+struct InputSnapshot
+{
+    static constexpr std::size_t max_controllers = 4;
+    // indexed by SDL_BUTTON_LEFT, SDL_BUTTON_MIDDLE, ...
+    static constexpr std::size_t max_mouse_buttons = 8;
+
+    InputTick tick{0};
+    ButtonSet<SDL_NUM_SCANCODES> keys;
+    ButtonSet<max_mouse_buttons> mouse_buttons;
+    Point<int> mouse_position{0, 0};
+    Point<int> mouse_motion_total{0, 0};
+    Point<int> mouse_wheel_total{0, 0};
+    std::array<ControllerState, max_controllers> controllers;
+};
+
+// A snapshot seen relative to the one read before it. Valid until the next InputTracker::read().
+class InputFrame
+{
+  public:
+    InputFrame(
+        const InputSnapshot& snapshot, InputTick previous_tick, Point<int> previous_motion_total,
+        Point<int> previous_wheel_total
+    ) noexcept;
+
+    [[nodiscard]] const InputSnapshot& snapshot() const noexcept
+    {
+        return *snapshot_;
+    }
+
+    [[nodiscard]] bool key_down(SDL_Scancode key) const noexcept
+    {
+        return snapshot_->keys.down[key];
+    }
+
+    [[nodiscard]] bool key_pressed(SDL_Scancode key) const noexcept
+    {
+        return is_new(snapshot_->keys.pressed_at[key]);
+    }
+
+    [[nodiscard]] bool key_released(SDL_Scancode key) const noexcept
+    {
+        return is_new(snapshot_->keys.released_at[key]);
+    }
+
+    [[nodiscard]] bool mouse_down(Uint8 button) const noexcept
+    {
+        return snapshot_->mouse_buttons.down[button];
+    }
+
+    [[nodiscard]] bool mouse_pressed(Uint8 button) const noexcept
+    {
+        return is_new(snapshot_->mouse_buttons.pressed_at[button]);
+    }
+
+    [[nodiscard]] bool mouse_released(Uint8 button) const noexcept
+    {
+        return is_new(snapshot_->mouse_buttons.released_at[button]);
+    }
+
+    [[nodiscard]] Point<int> mouse_position() const noexcept
+    {
+        return snapshot_->mouse_position;
+    }
+
+    [[nodiscard]] Point<int> mouse_motion() const noexcept
+    {
+        return mouse_motion_;
+    }
+
+    [[nodiscard]] Point<int> mouse_wheel() const noexcept
+    {
+        return mouse_wheel_;
+    }
+
+    [[nodiscard]] const ControllerState& controller(std::size_t slot) const noexcept
+    {
+        return snapshot_->controllers[slot];
+    }
+
+    [[nodiscard]] bool controller_down(std::size_t slot, SDL_GameControllerButton button) const noexcept
+    {
+        return controller(slot).buttons.down[button];
+    }
+
+    [[nodiscard]] bool controller_pressed(std::size_t slot, SDL_GameControllerButton button) const noexcept
+    {
+        return is_new(controller(slot).buttons.pressed_at[button]);
+    }
+
+    [[nodiscard]] bool controller_released(std::size_t slot, SDL_GameControllerButton button) const noexcept
+    {
+        return is_new(controller(slot).buttons.released_at[button]);
+    }
+
+    [[nodiscard]] Sint16 controller_axis(std::size_t slot, SDL_GameControllerAxis axis) const noexcept
+    {
+        return controller(slot).axes[axis];
+    }
+
+  private:
+    [[nodiscard]] bool is_new(InputTick tick) const noexcept
+    {
+        return tick > previous_tick_;
+    }
+
+    const InputSnapshot* snapshot_;
+    InputTick previous_tick_;
+    Point<int> mouse_motion_;
+    Point<int> mouse_wheel_;
+};
+
+struct GameControllerDeleter
+{
+    void operator()(SDL_GameController* controller) noexcept
+    {
+        SDL_GameControllerClose(controller);
+    }
+};
+
+using GameControllerUniquePtr = std::unique_ptr<SDL_GameController, GameControllerDeleter>;
+
+// Builds input state from events on the event thread and publishes one immutable snapshot per tick to a single
+// reader thread, e.g. the simulation. Game controllers are opened as they are attached.
+class InputTracker
+{
+  public:
+    InputTracker() noexcept;
+
+    // event thread: call for every polled event, then publish() once per tick
+    void handle_event(const Event& event);
+    void publish() noexcept;
+
+    // reader thread: returns the latest snapshot, with edges and motion since the previous read()
+    [[nodiscard]] InputFrame read() noexcept;
+
+  private:
+    void add_controller(int device_index);
+    void remove_controller(SDL_JoystickID id) noexcept;
+    [[nodiscard]] ControllerState* find_controller(SDL_JoystickID id) noexcept;
+
+    // touched only by the event thread
+    InputSnapshot state_{};
+    std::array<GameControllerUniquePtr, InputSnapshot::max_controllers> controllers_;
+
+    TripleBuffer<InputSnapshot> snapshots_;
+
+    // touched only by the reader thread
+    InputTick previous_tick_{0};
+    Point<int> previous_motion_total_{0, 0};
+    Point<int> previous_wheel_total_{0, 0};
+};
+
+} // namespace sdl
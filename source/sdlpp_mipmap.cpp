@@ -0,0 +1,399 @@
+#include "sdlpp_mipmap.h"
+
+#include "sdlpp.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SDLWRAP_HAVE_SSE2 1
+#endif
+
+namespace sdl {
+
+namespace {
+
+// below this many destination pixels per thread, starting threads costs more than it saves
+constexpr std::size_t min_pixels_per_thread = 65536;
+
+template <typename Function>
+void parallel_rows(int height, std::size_t pixels_per_row, std::size_t n_threads, Function function)
+{
+    const auto n_rows = static_cast<std::size_t>(height);
+    n_threads = std::clamp(
+        n_rows * pixels_per_row / min_pixels_per_thread, std::size_t{1}, std::max(n_threads, std::size_t{1})
+    );
+    if (n_threads == 1) {
+        function(0, height);
+        return;
+    }
+    const int chunk = static_cast<int>((n_rows + n_threads - 1) / n_threads);
+    std::vector<std::thread> threads;
+    threads.reserve(n_threads - 1);
+    for (int first = chunk; first < height; first += chunk) {
+        threads.emplace_back(function, first, std::min(first + chunk, height));
+    }
+    function(0, std::min(chunk, height));
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+const std::uint8_t* byte_row(const SDL_Surface& surface, int y) noexcept
+{
+    return static_cast<const std::uint8_t*>(surface.pixels) + static_cast<std::ptrdiff_t>(y) * surface.pitch;
+}
+
+std::uint8_t* byte_row(SDL_Surface& surface, int y) noexcept
+{
+    return static_cast<std::uint8_t*>(surface.pixels) + static_cast<std::ptrdiff_t>(y) * surface.pitch;
+}
+
+// the byte of each pixel that `mask` selects, or -1 when the mask is not exactly one whole byte
+int mask_byte(Uint32 mask) noexcept
+{
+    std::array<std::uint8_t, 4> bytes{};
+    std::memcpy(bytes.data(), &mask, bytes.size());
+    int found = -1;
+    for (int byte = 0; byte < 4; ++byte) {
+        if (bytes[byte] == 0xFF && found < 0) {
+            found = byte;
+        } else if (bytes[byte] != 0) {
+            return -1;
+        }
+    }
+    return found;
+}
+
+bool has_byte_channels(const SDL_PixelFormat& format) noexcept
+{
+    return format.BytesPerPixel == 4 && !SDL_ISPIXELFORMAT_FOURCC(format.format) && mask_byte(format.Rmask) >= 0 &&
+           mask_byte(format.Gmask) >= 0 && mask_byte(format.Bmask) >= 0 &&
+           (format.Amask == 0 || mask_byte(format.Amask) >= 0);
+}
+
+#ifdef SDLWRAP_HAVE_SSE2
+// averages 2x2 blocks of four top and four bottom pixels into two pixels, as 16-bit channel sums plus rounding
+__m128i average_blocks(__m128i top, __m128i bottom) noexcept
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i left = _mm_add_epi16(_mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));
+    const __m128i right = _mm_add_epi16(_mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));
+    // each half of `left` and `right` holds one source column; adding the halves sums the block
+    const __m128i sums = _mm_unpacklo_epi64(
+        _mm_add_epi16(left, _mm_srli_si128(left, 8)), _mm_add_epi16(right, _mm_srli_si128(right, 8))
+    );
+    return _mm_srli_epi16(_mm_add_epi16(sums, _mm_set1_epi16(2)), 2);
+}
+
+// multiplies the colors of two pixels held as 16-bit channels by their alpha at `AlphaByte`, keeping alpha itself
+template <int AlphaByte>
+__m128i premultiply(__m128i pixels) noexcept
+{
+    constexpr int alpha_lanes = _MM_SHUFFLE(AlphaByte, AlphaByte, AlphaByte, AlphaByte);
+    const __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(pixels, alpha_lanes), alpha_lanes);
+    const __m128i alpha_mask = _mm_slli_si128(_mm_set_epi32(0, 0xFFFF, 0, 0xFFFF), 2 * AlphaByte);
+    const __m128i premultiplied = _mm_mullo_epi16(pixels, alpha);
+    return _mm_or_si128(_mm_andnot_si128(alpha_mask, premultiplied), _mm_and_si128(alpha_mask, pixels));
+}
+
+// one pixel from the 32-bit sums of premultiplied colors and of alpha over its block, as 32-bit channels
+template <int AlphaByte>
+__m128i unpremultiply(__m128i sums) noexcept
+{
+    constexpr int alpha_lanes = _MM_SHUFFLE(AlphaByte, AlphaByte, AlphaByte, AlphaByte);
+    const __m128 float_sums = _mm_cvtepi32_ps(sums);
+    // a fully transparent block sums to zero colors, so dividing by one leaves them black
+    const __m128 alpha = _mm_max_ps(_mm_shuffle_ps(float_sums, float_sums, alpha_lanes), _mm_set1_ps(1.0F));
+    const __m128i colors = _mm_cvtps_epi32(_mm_div_ps(float_sums, alpha));
+    const __m128i averaged_alpha = _mm_srli_epi32(_mm_add_epi32(sums, _mm_set1_epi32(2)), 2);
+    const __m128i alpha_mask = _mm_slli_si128(_mm_cvtsi32_si128(-1), 4 * AlphaByte);
+    return _mm_or_si128(_mm_andnot_si128(alpha_mask, colors), _mm_and_si128(alpha_mask, averaged_alpha));
+}
+
+// two pixels as 32-bit channels each
+struct WidePixels
+{
+    __m128i first;
+    __m128i second;
+};
+
+// as average_blocks, but weighting colors by alpha
+template <int AlphaByte>
+WidePixels weighted_average_blocks(__m128i top, __m128i bottom) noexcept
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i top_left = premultiply<AlphaByte>(_mm_unpacklo_epi8(top, zero));
+    const __m128i top_right = premultiply<AlphaByte>(_mm_unpackhi_epi8(top, zero));
+    const __m128i bottom_left = premultiply<AlphaByte>(_mm_unpacklo_epi8(bottom, zero));
+    const __m128i bottom_right = premultiply<AlphaByte>(_mm_unpackhi_epi8(bottom, zero));
+    // premultiplied channels reach 255 * 255, so the four of a block are summed at 32 bits
+    const auto block_sums = [zero](__m128i top_pixels, __m128i bottom_pixels) {
+        return _mm_add_epi32(
+            _mm_add_epi32(_mm_unpacklo_epi16(top_pixels, zero), _mm_unpackhi_epi16(top_pixels, zero)),
+            _mm_add_epi32(_mm_unpacklo_epi16(bottom_pixels, zero), _mm_unpackhi_epi16(bottom_pixels, zero))
+        );
+    };
+    return {
+        unpremultiply<AlphaByte>(block_sums(top_left, bottom_left)),
+        unpremultiply<AlphaByte>(block_sums(top_right, bottom_right)),
+    };
+}
+
+template <int AlphaByte>
+int downscale_weighted_sse2(
+    const std::uint8_t* top, const std::uint8_t* bottom, int source_width, std::uint8_t* destination, int width
+) noexcept
+{
+    int x = 0;
+    for (; 2 * (x + 4) <= source_width && x + 4 <= width; x += 4) {
+        const auto* top_pixels = reinterpret_cast<const __m128i*>(top + 8 * x);
+        const auto* bottom_pixels = reinterpret_cast<const __m128i*>(bottom + 8 * x);
+        const WidePixels low =
+            weighted_average_blocks<AlphaByte>(_mm_loadu_si128(top_pixels), _mm_loadu_si128(bottom_pixels));
+        const WidePixels high =
+            weighted_average_blocks<AlphaByte>(_mm_loadu_si128(top_pixels + 1), _mm_loadu_si128(bottom_pixels + 1));
+        const __m128i pixels = _mm_packus_epi16(
+            _mm_packs_epi32(low.first, low.second), _mm_packs_epi32(high.first, high.second)
+        );
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + 4 * x), pixels);
+    }
+    return x;
+}
+#endif
+
+// `alpha_byte` is the byte holding alpha, or -1 without alpha. With alpha, colors are averaged weighted by it, which
+// equals premultiplying, filtering and dividing by alpha again, so transparent pixels do not bleed into opaque edges.
+void downscale_row(
+    const std::uint8_t* top,
+    const std::uint8_t* bottom,
+    int source_width,
+    std::uint8_t* destination,
+    int width,
+    int alpha_byte
+) noexcept
+{
+    int x = 0;
+#ifdef SDLWRAP_HAVE_SSE2
+    // eight whole source columns per four destination pixels; the clamped last column is left to the scalar loop
+    switch (alpha_byte) {
+    case 0:
+        x = downscale_weighted_sse2<0>(top, bottom, source_width, destination, width);
+        break;
+    case 1:
+        x = downscale_weighted_sse2<1>(top, bottom, source_width, destination, width);
+        break;
+    case 2:
+        x = downscale_weighted_sse2<2>(top, bottom, source_width, destination, width);
+        break;
+    case 3:
+        x = downscale_weighted_sse2<3>(top, bottom, source_width, destination, width);
+        break;
+    default:
+        for (; 2 * (x + 4) <= source_width && x + 4 <= width; x += 4) {
+            const auto* top_pixels = reinterpret_cast<const __m128i*>(top + 8 * x);
+            const auto* bottom_pixels = reinterpret_cast<const __m128i*>(bottom + 8 * x);
+            const __m128i low = average_blocks(_mm_loadu_si128(top_pixels), _mm_loadu_si128(bottom_pixels));
+            const __m128i high =
+                average_blocks(_mm_loadu_si128(top_pixels + 1), _mm_loadu_si128(bottom_pixels + 1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + 4 * x), _mm_packus_epi16(low, high));
+        }
+        break;
+    }
+#endif
+    for (; x < width; ++x) {
+        const std::array<const std::uint8_t*, 4> block{
+            top + 8 * x,
+            top + 4 * std::min(2 * x + 1, source_width - 1),
+            bottom + 8 * x,
+            bottom + 4 * std::min(2 * x + 1, source_width - 1),
+        };
+        if (alpha_byte < 0) {
+            for (int byte = 0; byte < 4; ++byte) {
+                const int sum = block[0][byte] + block[1][byte] + block[2][byte] + block[3][byte];
+                destination[4 * x + byte] = static_cast<std::uint8_t>((sum + 2) >> 2);
+            }
+            continue;
+        }
+        int alpha_sum = 0;
+        for (const std::uint8_t* pixel : block) {
+            alpha_sum += pixel[alpha_byte];
+        }
+        // the same float division and round half to even as the SSE2 path, so both give identical pixels
+        const float divisor = std::max(static_cast<float>(alpha_sum), 1.0F);
+        for (int byte = 0; byte < 4; ++byte) {
+            if (byte == alpha_byte) {
+                destination[4 * x + byte] = static_cast<std::uint8_t>((alpha_sum + 2) >> 2);
+                continue;
+            }
+            int sum = 0;
+            for (const std::uint8_t* pixel : block) {
+                sum += pixel[byte] * pixel[alpha_byte];
+            }
+            destination[4 * x + byte] = static_cast<std::uint8_t>(std::nearbyint(static_cast<float>(sum) / divisor));
+        }
+    }
+}
+
+class SurfaceLock
+{
+  public:
+    explicit SurfaceLock(SDL_Surface& surface) : surface_{surface}
+    {
+        if (SDL_MUSTLOCK(&surface_) && SDL_LockSurface(&surface_) != 0) {
+            throw GenericError{};
+        }
+    }
+    SurfaceLock(const SurfaceLock&) = delete;
+    SurfaceLock& operator=(const SurfaceLock&) = delete;
+
+    ~SurfaceLock()
+    {
+        if (SDL_MUSTLOCK(&surface_)) {
+            SDL_UnlockSurface(&surface_);
+        }
+    }
+
+  private:
+    SDL_Surface& surface_;
+};
+
+int ceil_int(float value) noexcept
+{
+    return static_cast<int>(std::ceil(value));
+}
+
+} // namespace
+
+SurfaceUniquePtr downscale_half(SDL_Surface& surface, std::size_t n_threads)
+{
+    if (!has_byte_channels(*surface.format)) {
+        throw std::invalid_argument{"downscaling needs a 32-bit format with 8 bits per channel"};
+    }
+    const int alpha_byte = surface.format->Amask == 0 ? -1 : mask_byte(surface.format->Amask);
+
+    const int width = (surface.w + 1) / 2;
+    const int height = (surface.h + 1) / 2;
+    SurfaceUniquePtr result = make_surface(width, height, surface.format->format);
+    const SurfaceLock source_lock{surface};
+    const SurfaceLock destination_lock{*result};
+    parallel_rows(height, static_cast<std::size_t>(width), n_threads, [&](int first, int last) {
+        for (int y = first; y < last; ++y) {
+            const std::uint8_t* top = byte_row(surface, 2 * y);
+            const std::uint8_t* bottom = byte_row(surface, std::min(2 * y + 1, surface.h - 1));
+            downscale_row(top, bottom, surface.w, byte_row(*result, y), width, alpha_byte);
+        }
+    });
+    return result;
+}
+
+MipmappedImage::MipmappedImage(SurfaceUniquePtr base, const MipmapConfig& config)
+{
+    if (base == nullptr) {
+        throw std::invalid_argument{"mipmapped image without a base surface"};
+    }
+    // a color key would be averaged like any color, so it is turned into alpha along with other formats
+    if (!has_byte_channels(*base->format) || SDL_HasColorKey(base.get())) {
+        base = convert_surface_format(std::move(base), SDL_PIXELFORMAT_ARGB8888);
+    }
+    const int min_size = std::max(config.min_size, 1);
+    levels_.push_back(Level{{base->w, base->h}, std::move(base), Texture{}});
+    while (true) {
+        SDL_Surface& previous = *levels_.back().surface;
+        if (previous.w <= min_size && previous.h <= min_size) {
+            break;
+        }
+        SurfaceUniquePtr level = downscale_half(previous, config.n_threads);
+        const Point<int> size{level->w, level->h};
+        levels_.push_back(Level{size, std::move(level), Texture{}});
+    }
+}
+
+std::size_t MipmappedImage::select_level(Point<int> destination_size) const noexcept
+{
+    std::size_t selected = levels_.size();
+    for (std::size_t level = 0; level < levels_.size(); ++level) {
+        if (!is_available(level)) {
+            continue;
+        }
+        const Point<int> level_size = levels_[level].size;
+        if (level_size.x < destination_size.x || level_size.y < destination_size.y) {
+            // every later level is smaller still
+            return selected == levels_.size() ? level : selected;
+        }
+        selected = level;
+    }
+    return selected == levels_.size() ? 0 : selected;
+}
+
+SDL_Texture& MipmappedImage::texture(const Renderer& renderer, std::size_t level)
+{
+    Level& selected = levels_.at(level);
+    if (selected.texture.get_pointer() == nullptr) {
+        if (selected.surface == nullptr) {
+            throw std::logic_error{"mipmap level was released"};
+        }
+        selected.texture = Texture{renderer.make_texture_from_surface(selected.surface.get())};
+        // the selected level is at most twice the destination size, which linear filtering covers without aliasing
+        if (SDL_SetTextureScaleMode(selected.texture.get_pointer(), SDL_ScaleModeLinear) != 0) {
+            throw GenericError{};
+        }
+    }
+    return *selected.texture.get_pointer();
+}
+
+template <RectangleT DestinationRectangle>
+void MipmappedImage::draw(Renderer& renderer, const DestinationRectangle& destination)
+{
+    Point<int> destination_size;
+    if constexpr (std::is_same_v<DestinationRectangle, Rectangle<float>>) {
+        destination_size = {ceil_int(destination.w), ceil_int(destination.h)};
+    } else {
+        destination_size = {destination.w, destination.h};
+    }
+    const std::size_t level = select_level(destination_size);
+    SDL_Texture& level_texture = texture(renderer, level);
+    const Point<int> size = levels_[level].size;
+    renderer.copy(level_texture, Rectangle<int>{0, 0, size.x, size.y}, destination);
+}
+
+template void MipmappedImage::draw<Rectangle<int>>(Renderer& renderer, const Rectangle<int>& destination);
+template void MipmappedImage::draw<Rectangle<float>>(Renderer& renderer, const Rectangle<float>& destination);
+
+void MipmappedImage::release_surfaces() noexcept
+{
+    for (Level& level : levels_) {
+        level.surface.reset();
+    }
+}
+
+void MipmappedImage::release_textures() noexcept
+{
+    for (Level& level : levels_) {
+        level.texture = Texture{};
+    }
+}
+
+void MipmappedImage::release_level(std::size_t level) noexcept
+{
+    if (level < levels_.size()) {
+        levels_[level].surface.reset();
+        levels_[level].texture = Texture{};
+    }
+}
+
+bool MipmappedImage::is_available(std::size_t level) const noexcept
+{
+    return level < levels_.size() &&
+           (levels_[level].surface != nullptr || levels_[level].texture.get_pointer() != nullptr);
+}
+
+} // namespace sdl
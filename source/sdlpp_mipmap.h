@@ -0,0 +1,70 @@
+#pragma once
+
+#include "sdlpp.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace sdl {
+
+struct MipmapConfig
+{
+    // levels are generated down to this edge length, or 1x1 when 1
+    int min_size = 1;
+    // `n_threads` > 1 splits large levels across that many threads
+    std::size_t n_threads = 1;
+};
+
+// Halves `surface` in both dimensions, rounding up, with a 2x2 box filter, keeping its format. Odd trailing rows and
+// columns are averaged with themselves. The format must be 32-bit with 8 bits per channel, or std::invalid_argument is
+// thrown. Colors are weighted by alpha so transparent pixels do not bleed into opaque edges; color keys are ignored.
+[[nodiscard]] SurfaceUniquePtr downscale_half(SDL_Surface& surface, std::size_t n_threads = 1);
+
+// Base image plus successively halved levels, uploaded to textures only when a level is first drawn. Drawing picks the
+// smallest level that still covers the destination, so a thumbnail samples a thumbnail-sized texture.
+class MipmappedImage
+{
+  public:
+    explicit MipmappedImage(SurfaceUniquePtr base, const MipmapConfig& config = {});
+
+    // the smallest available level at least as large as `destination_size`, or the largest available level when none
+    // is; the base level is 0
+    [[nodiscard]] std::size_t select_level(Point<int> destination_size) const noexcept;
+
+    // the texture for `level`, uploaded from its surface on first use
+    [[nodiscard]] SDL_Texture& texture(const Renderer& renderer, std::size_t level);
+
+    template <RectangleT DestinationRectangle>
+    void draw(Renderer& renderer, const DestinationRectangle& destination);
+
+    // frees every level's pixels; levels never uploaded become unavailable and are skipped by select_level
+    void release_surfaces() noexcept;
+    // frees every uploaded texture, e.g. before the renderer is destroyed; levels with pixels left upload again
+    void release_textures() noexcept;
+    // frees the pixels and texture of `level`, making it unavailable
+    void release_level(std::size_t level) noexcept;
+
+    [[nodiscard]] bool is_available(std::size_t level) const noexcept;
+
+    [[nodiscard]] std::size_t n_levels() const noexcept
+    {
+        return levels_.size();
+    }
+
+    [[nodiscard]] Point<int> size(std::size_t level = 0) const noexcept
+    {
+        return levels_[level].size;
+    }
+
+  private:
+    struct Level
+    {
+        Point<int> size;
+        SurfaceUniquePtr surface;
+        Texture texture;
+    };
+
+    std::vector<Level> levels_;
+};
+
+} // namespace sdl
@@ -0,0 +1,294 @@
+#include "sdlpp_particles.h"
+
+#include "sdlpp.h"
+
+#include <gsl/gsl>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SDLWRAP_HAVE_SSE2 1
+#endif
+
+namespace sdl {
+
+namespace {
+
+// below this many particles per thread, waking a worker costs more than it saves
+constexpr std::size_t min_particles_per_thread = 16384;
+
+} // namespace
+
+// Threads that sleep between frames and each run one index of a task, so update() and draw() wake them instead of
+// starting and joining threads every call.
+class ParticleSystem::Workers
+{
+  public:
+    explicit Workers(std::size_t n_threads)
+    {
+        threads_.reserve(n_threads);
+        for (std::size_t index = 1; index <= n_threads; ++index) {
+            threads_.emplace_back(&Workers::work, this, index);
+        }
+    }
+    Workers(const Workers&) = delete;
+    Workers& operator=(const Workers&) = delete;
+
+    ~Workers()
+    {
+        {
+            const std::scoped_lock lock{mutex_};
+            stopping_ = true;
+        }
+        task_ready_.notify_all();
+        for (std::thread& thread : threads_) {
+            thread.join();
+        }
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept
+    {
+        return threads_.size();
+    }
+
+    // calls `function(index)` for every index up to size() on the workers and index 0 on the calling thread, and
+    // returns once all calls have; `function` must not throw
+    template <typename Function>
+    void run(Function& function)
+    {
+        {
+            const std::scoped_lock lock{mutex_};
+            task_ = [](void* context, std::size_t index) { (*static_cast<Function*>(context))(index); };
+            context_ = &function;
+            n_running_ = threads_.size();
+            ++generation_;
+        }
+        task_ready_.notify_all();
+        function(std::size_t{0});
+
+        std::unique_lock lock{mutex_};
+        task_done_.wait(lock, [this] { return n_running_ == 0; });
+    }
+
+  private:
+    void work(std::size_t index)
+    {
+        std::uint64_t generation = 0;
+        while (true) {
+            void (*task)(void*, std::size_t) = nullptr;
+            void* context = nullptr;
+            {
+                std::unique_lock lock{mutex_};
+                task_ready_.wait(lock, [&] { return stopping_ || generation_ != generation; });
+                if (stopping_) {
+                    return;
+                }
+                generation = generation_;
+                task = task_;
+                context = context_;
+            }
+            task(context, index);
+
+            const std::scoped_lock lock{mutex_};
+            if (--n_running_ == 0) {
+                task_done_.notify_one();
+            }
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable task_ready_;
+    std::condition_variable task_done_;
+    void (*task_)(void*, std::size_t){nullptr};
+    void* context_{nullptr};
+    std::size_t n_running_{0};
+    std::uint64_t generation_{0};
+    bool stopping_{false};
+    std::vector<std::thread> threads_;
+};
+
+ParticleSystem::ParticleSystem(std::size_t capacity, float particle_size, SDL_Texture* texture)
+    : half_size_{particle_size / 2.0F},
+      texture_{texture},
+      positions_x_(capacity),
+      positions_y_(capacity),
+      velocities_x_(capacity),
+      velocities_y_(capacity),
+      lifetimes_(capacity),
+      colors_(capacity),
+      quad_positions_(8 * capacity),
+      quad_colors_(4 * capacity),
+      quad_texture_coordinates_(8 * capacity),
+      quad_indices_(6 * capacity)
+{
+    constexpr float corners[8] = {0.0F, 0.0F, 1.0F, 0.0F, 1.0F, 1.0F, 0.0F, 1.0F};
+    constexpr int corner_indices[6] = {0, 1, 2, 0, 2, 3};
+    for (std::size_t i = 0; i < capacity; ++i) {
+        std::copy(std::begin(corners), std::end(corners), quad_texture_coordinates_.begin() + 8 * i);
+        for (std::size_t j = 0; j < 6; ++j) {
+            quad_indices_[6 * i + j] = gsl::narrow<int>(4 * i) + corner_indices[j];
+        }
+    }
+}
+
+ParticleSystem::ParticleSystem(ParticleSystem&& other) noexcept = default;
+ParticleSystem& ParticleSystem::operator=(ParticleSystem&& other) noexcept = default;
+ParticleSystem::~ParticleSystem() = default;
+
+bool ParticleSystem::spawn(const ParticleSpawn& particle) noexcept
+{
+    if (size_ == capacity()) {
+        return false;
+    }
+    positions_x_[size_] = particle.position.x;
+    positions_y_[size_] = particle.position.y;
+    velocities_x_[size_] = particle.velocity.x;
+    velocities_y_[size_] = particle.velocity.y;
+    lifetimes_[size_] = particle.lifetime;
+    colors_[size_] = particle.color;
+    ++size_;
+    return true;
+}
+
+std::size_t ParticleSystem::spawn(std::span<const ParticleSpawn> particles) noexcept
+{
+    std::size_t n_spawned = 0;
+    for (const ParticleSpawn& particle : particles) {
+        if (!spawn(particle)) {
+            break;
+        }
+        ++n_spawned;
+    }
+    return n_spawned;
+}
+
+void ParticleSystem::update(float seconds, Point<float> acceleration, std::size_t n_threads)
+{
+    n_threads_ = std::max(n_threads, std::size_t{1});
+    parallel_for([&](std::size_t first, std::size_t last) { integrate(first, last, seconds, acceleration); });
+    compact();
+}
+
+void ParticleSystem::draw(const Renderer& renderer)
+{
+    if (size_ == 0) {
+        return;
+    }
+    parallel_for([this](std::size_t first, std::size_t last) { build_quads(first, last); });
+    renderer.render_geometry(
+        texture_,
+        std::span{quad_positions_}.first(8 * size_),
+        std::span{quad_colors_}.first(4 * size_),
+        texture_ == nullptr ? std::span<const float>{} : std::span{quad_texture_coordinates_}.first(8 * size_),
+        std::span{quad_indices_}.first(6 * size_)
+    );
+}
+
+template <typename Function>
+void ParticleSystem::parallel_for(Function function)
+{
+    const std::size_t n_threads = std::clamp(size_ / min_particles_per_thread, std::size_t{1}, n_threads_);
+    if (n_threads == 1) {
+        function(std::size_t{0}, size_);
+        return;
+    }
+    if (workers_ == nullptr || workers_->size() != n_threads_ - 1) {
+        workers_.reset();
+        workers_ = std::make_unique<Workers>(n_threads_ - 1);
+    }
+    // workers past `n_threads` get empty ranges
+    const std::size_t chunk = (size_ + n_threads - 1) / n_threads;
+    auto run_chunk = [&](std::size_t index) {
+        const std::size_t first = std::min(index * chunk, size_);
+        const std::size_t last = std::min(first + chunk, size_);
+        if (first < last) {
+            function(first, last);
+        }
+    };
+    workers_->run(run_chunk);
+}
+
+void ParticleSystem::integrate(std::size_t first, std::size_t last, float seconds, Point<float> acceleration) noexcept
+{
+    float* const __restrict x = positions_x_.data();
+    float* const __restrict y = positions_y_.data();
+    float* const __restrict velocity_x = velocities_x_.data();
+    float* const __restrict velocity_y = velocities_y_.data();
+    float* const __restrict lifetime = lifetimes_.data();
+
+    std::size_t i = first;
+#ifdef SDLWRAP_HAVE_SSE2
+    const __m128 step = _mm_set1_ps(seconds);
+    const __m128 step_x = _mm_set1_ps(acceleration.x * seconds);
+    const __m128 step_y = _mm_set1_ps(acceleration.y * seconds);
+    for (; i + 4 <= last; i += 4) {
+        const __m128 new_velocity_x = _mm_add_ps(_mm_loadu_ps(velocity_x + i), step_x);
+        const __m128 new_velocity_y = _mm_add_ps(_mm_loadu_ps(velocity_y + i), step_y);
+        _mm_storeu_ps(velocity_x + i, new_velocity_x);
+        _mm_storeu_ps(velocity_y + i, new_velocity_y);
+        _mm_storeu_ps(x + i, _mm_add_ps(_mm_loadu_ps(x + i), _mm_mul_ps(new_velocity_x, step)));
+        _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(new_velocity_y, step)));
+        _mm_storeu_ps(lifetime + i, _mm_sub_ps(_mm_loadu_ps(lifetime + i), step));
+    }
+#endif
+    for (; i < last; ++i) {
+        velocity_x[i] += acceleration.x * seconds;
+        velocity_y[i] += acceleration.y * seconds;
+        x[i] += velocity_x[i] * seconds;
+        y[i] += velocity_y[i] * seconds;
+        lifetime[i] -= seconds;
+    }
+}
+
+void ParticleSystem::build_quads(std::size_t first, std::size_t last) noexcept
+{
+    const float* const __restrict x = positions_x_.data();
+    const float* const __restrict y = positions_y_.data();
+    float* const __restrict quad = quad_positions_.data();
+    for (std::size_t i = first; i < last; ++i) {
+        const float left = x[i] - half_size_;
+        const float right = x[i] + half_size_;
+        const float top = y[i] - half_size_;
+        const float bottom = y[i] + half_size_;
+        float* const corners = quad + 8 * i;
+        corners[0] = left;
+        corners[1] = top;
+        corners[2] = right;
+        corners[3] = top;
+        corners[4] = right;
+        corners[5] = bottom;
+        corners[6] = left;
+        corners[7] = bottom;
+    }
+    for (std::size_t i = first; i < last; ++i) {
+        std::fill_n(quad_colors_.begin() + static_cast<std::ptrdiff_t>(4 * i), 4, colors_[i]);
+    }
+}
+
+void ParticleSystem::compact() noexcept
+{
+    std::size_t i = 0;
+    while (i < size_) {
+        if (lifetimes_[i] > 0.0F) {
+            ++i;
+            continue;
+        }
+        // fill the hole with the last particle; order is not preserved
+        --size_;
+        positions_x_[i] = positions_x_[size_];
+        positions_y_[i] = positions_y_[size_];
+        velocities_x_[i] = velocities_x_[size_];
+        velocities_y_[i] = velocities_y_[size_];
+        lifetimes_[i] = lifetimes_[size_];
+        colors_[i] = colors_[size_];
+    }
+}
+
+} // namespace sdl
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "sdlpp.h"
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace sdl {
+
+struct ParticleSpawn
+{
+    Point<float> position;
+    Point<float> velocity;
+    Color color;
+    // seconds
+    float lifetime;
+};
+
+// Particle engine storing each attribute in its own array. Updates run as vectorized loops over those arrays,
+// optionally split across threads the system keeps between frames; dead particles are compacted in place, and all live
+// particles are drawn as quads in a single SDL_RenderGeometryRaw call. Storage for `capacity` particles is allocated
+// once up front.
+class ParticleSystem
+{
+  public:
+    ParticleSystem(std::size_t capacity, float particle_size = 2.0F, SDL_Texture* texture = nullptr);
+    ParticleSystem(ParticleSystem&& other) noexcept;
+    ParticleSystem& operator=(ParticleSystem&& other) noexcept;
+    ~ParticleSystem();
+
+    // returns false when the system is full
+    bool spawn(const ParticleSpawn& particle) noexcept;
+    // returns the number of particles spawned
+    std::size_t spawn(std::span<const ParticleSpawn> particles) noexcept;
+
+    // advances every particle by `seconds` under constant `acceleration`, then removes expired particles;
+    // `n_threads` > 1 splits the arrays across that many threads
+    void update(float seconds, Point<float> acceleration = {0.0F, 0.0F}, std::size_t n_threads = 1);
+
+    // draws every live particle as a `particle_size` square centered on its position, textured with the whole
+    // texture when one was given
+    void draw(const Renderer& renderer);
+
+    void clear() noexcept
+    {
+        size_ = 0;
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept
+    {
+        return size_;
+    }
+
+    [[nodiscard]] std::size_t capacity() const noexcept
+    {
+        return lifetimes_.size();
+    }
+
+    [[nodiscard]] std::span<const float> positions_x() const noexcept
+    {
+        return {positions_x_.data(), size_};
+    }
+
+    [[nodiscard]] std::span<const float> positions_y() const noexcept
+    {
+        return {positions_y_.data(), size_};
+    }
+
+  private:
+    class Workers;
+
+    // calls `function(first, last)` on consecutive ranges covering the live particles, on up to `n_threads_` threads
+    template <typename Function>
+    void parallel_for(Function function);
+    void integrate(std::size_t first, std::size_t last, float seconds, Point<float> acceleration) noexcept;
+    void build_quads(std::size_t first, std::size_t last) noexcept;
+    void compact() noexcept;
+
+    float half_size_;
+    SDL_Texture* texture_;
+    std::size_t size_{0};
+    std::size_t n_threads_{1};
+    // started on first use with n_threads_ - 1 threads, the calling thread taking the first range
+    std::unique_ptr<Workers> workers_;
+
+    std::vector<float> positions_x_;
+    std::vector<float> positions_y_;
+    std::vector<float> velocities_x_;
+    std::vector<float> velocities_y_;
+    std::vector<float> lifetimes_;
+    std::vector<Color> colors_;
+
+    // quad geometry: four corners per particle; texture coordinates and indices never change
+    std::vector<float> quad_positions_;
+    std::vector<Color> quad_colors_;
+    std::vector<float> quad_texture_coordinates_;
+    std::vector<int> quad_indices_;
+};
+
+} // namespace sdl
@@ -0,0 +1,425 @@
+#include "sdlpp_recorder.h"
+
+#include "sdlpp.h"
+#include "sdlpp_capture.h"
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SDLWRAP_HAVE_SSE2 1
+#endif
+
+namespace sdl {
+
+namespace {
+
+// full-range BT.601 in 8.8 fixed point, matching Y4M's C420jpeg
+constexpr std::uint8_t luma(int red, int green, int blue) noexcept
+{
+    return static_cast<std::uint8_t>((77 * red + 150 * green + 29 * blue + 128) >> 8);
+}
+
+constexpr std::uint8_t chroma_u(int red, int green, int blue) noexcept
+{
+    return static_cast<std::uint8_t>(std::clamp(((128 * blue - 43 * red - 85 * green + 128) >> 8) + 128, 0, 255));
+}
+
+constexpr std::uint8_t chroma_v(int red, int green, int blue) noexcept
+{
+    return static_cast<std::uint8_t>(std::clamp(((128 * red - 107 * green - 21 * blue + 128) >> 8) + 128, 0, 255));
+}
+
+constexpr int red(Uint32 pixel) noexcept
+{
+    return static_cast<int>((pixel >> 16U) & 0xFFU);
+}
+
+constexpr int green(Uint32 pixel) noexcept
+{
+    return static_cast<int>((pixel >> 8U) & 0xFFU);
+}
+
+constexpr int blue(Uint32 pixel) noexcept
+{
+    return static_cast<int>(pixel & 0xFFU);
+}
+
+const Uint32* pixel_row(const void* pixels, int pitch, int y) noexcept
+{
+    const auto* row = static_cast<const std::uint8_t*>(pixels) + static_cast<std::ptrdiff_t>(y) * pitch;
+    return reinterpret_cast<const Uint32*>(row);
+}
+
+void convert_luma_row(const Uint32* source, int width, std::uint8_t* destination) noexcept
+{
+    int x = 0;
+#ifdef SDLWRAP_HAVE_SSE2
+    const __m128i channel_mask = _mm_set1_epi32(0xFF);
+    const __m128i red_weight = _mm_set1_epi16(77);
+    const __m128i green_weight = _mm_set1_epi16(150);
+    const __m128i blue_weight = _mm_set1_epi16(29);
+    const __m128i rounding = _mm_set1_epi16(128);
+    for (; x + 8 <= width; x += 8) {
+        const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + x));
+        const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + x + 4));
+        const __m128i reds = _mm_packs_epi32(
+            _mm_and_si128(_mm_srli_epi32(low, 16), channel_mask), _mm_and_si128(_mm_srli_epi32(high, 16), channel_mask)
+        );
+        const __m128i greens = _mm_packs_epi32(
+            _mm_and_si128(_mm_srli_epi32(low, 8), channel_mask), _mm_and_si128(_mm_srli_epi32(high, 8), channel_mask)
+        );
+        const __m128i blues = _mm_packs_epi32(_mm_and_si128(low, channel_mask), _mm_and_si128(high, channel_mask));
+        // the weighted sum stays below 2^16, so wrapping 16-bit arithmetic followed by a logical shift is exact
+        __m128i sum = _mm_add_epi16(_mm_mullo_epi16(reds, red_weight), _mm_mullo_epi16(greens, green_weight));
+        sum = _mm_add_epi16(sum, _mm_mullo_epi16(blues, blue_weight));
+        sum = _mm_srli_epi16(_mm_add_epi16(sum, rounding), 8);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(destination + x), _mm_packus_epi16(sum, sum));
+    }
+#endif
+    for (; x < width; ++x) {
+        destination[x] = luma(red(source[x]), green(source[x]), blue(source[x]));
+    }
+}
+
+#ifdef SDLWRAP_HAVE_SSE2
+// sums one channel over 2x2 blocks of 8 source columns: four 32-bit lanes per row register in, 16-bit sums out
+__m128i sum_blocks(__m128i top_low, __m128i top_high, __m128i bottom_low, __m128i bottom_high) noexcept
+{
+    const __m128i columns = _mm_packs_epi32(_mm_add_epi32(top_low, bottom_low), _mm_add_epi32(top_high, bottom_high));
+    return _mm_madd_epi16(columns, _mm_set1_epi16(1));
+}
+
+__m128i channel(__m128i pixels, int shift) noexcept
+{
+    return _mm_and_si128(_mm_srl_epi32(pixels, _mm_cvtsi32_si128(shift)), _mm_set1_epi32(0xFF));
+}
+
+// computes ((weights . rgb + 128) >> 8) + 128 for signed weights without overflowing 16 bits
+__m128i chroma(__m128i reds, __m128i greens, __m128i blues, short red_weight, short green_weight, short blue_weight)
+    noexcept
+{
+    __m128i sum = _mm_add_epi16(
+        _mm_mullo_epi16(reds, _mm_set1_epi16(red_weight)), _mm_mullo_epi16(greens, _mm_set1_epi16(green_weight))
+    );
+    sum = _mm_add_epi16(sum, _mm_mullo_epi16(blues, _mm_set1_epi16(blue_weight)));
+    sum = _mm_srai_epi16(_mm_add_epi16(_mm_srai_epi16(sum, 1), _mm_set1_epi16(64)), 7);
+    return _mm_add_epi16(sum, _mm_set1_epi16(128));
+}
+#endif
+
+void convert_chroma_row(
+    const Uint32* top, const Uint32* bottom, int width, std::uint8_t* destination_u, std::uint8_t* destination_v
+) noexcept
+{
+    const int chroma_width = (width + 1) / 2;
+    int x = 0;
+#ifdef SDLWRAP_HAVE_SSE2
+    const __m128i rounding = _mm_set1_epi16(2);
+    for (; 2 * x + 16 <= width; x += 8) {
+        __m128i top_pixels[4];
+        __m128i bottom_pixels[4];
+        for (int i = 0; i < 4; ++i) {
+            top_pixels[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(top + 2 * x + 4 * i));
+            bottom_pixels[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bottom + 2 * x + 4 * i));
+        }
+        __m128i averages[3];
+        for (int c = 0; c < 3; ++c) {
+            const int shift = 16 - 8 * c;
+            const __m128i left = sum_blocks(
+                channel(top_pixels[0], shift),
+                channel(top_pixels[1], shift),
+                channel(bottom_pixels[0], shift),
+                channel(bottom_pixels[1], shift)
+            );
+            const __m128i right = sum_blocks(
+                channel(top_pixels[2], shift),
+                channel(top_pixels[3], shift),
+                channel(bottom_pixels[2], shift),
+                channel(bottom_pixels[3], shift)
+            );
+            averages[c] = _mm_srli_epi16(_mm_add_epi16(_mm_packs_epi32(left, right), rounding), 2);
+        }
+        const __m128i u = chroma(averages[0], averages[1], averages[2], -43, -85, 128);
+        const __m128i v = chroma(averages[0], averages[1], averages[2], 128, -107, -21);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(destination_u + x), _mm_packus_epi16(u, u));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(destination_v + x), _mm_packus_epi16(v, v));
+    }
+#endif
+    for (; x < chroma_width; ++x) {
+        const int left = 2 * x;
+        const int right = std::min(left + 1, width - 1);
+        const Uint32 block[4] = {top[left], top[right], bottom[left], bottom[right]};
+        int red_sum = 2;
+        int green_sum = 2;
+        int blue_sum = 2;
+        for (const Uint32 pixel : block) {
+            red_sum += red(pixel);
+            green_sum += green(pixel);
+            blue_sum += blue(pixel);
+        }
+        destination_u[x] = chroma_u(red_sum >> 2, green_sum >> 2, blue_sum >> 2);
+        destination_v[x] = chroma_v(red_sum >> 2, green_sum >> 2, blue_sum >> 2);
+    }
+}
+
+std::string y4m_header(int width, int height, const RecorderConfig& config)
+{
+    return "YUV4MPEG2 W" + std::to_string(width) + " H" + std::to_string(height) + " F" +
+           std::to_string(config.frame_rate_numerator) + ":" + std::to_string(config.frame_rate_denominator) +
+           " Ip A1:1 C420jpeg\n";
+}
+
+constexpr std::string_view y4m_frame_header = "FRAME\n";
+
+} // namespace
+
+std::size_t i420_frame_size(int width, int height) noexcept
+{
+    const auto luma_size = static_cast<std::size_t>(width) * static_cast<std::size_t>(height);
+    const auto chroma_size = static_cast<std::size_t>((width + 1) / 2) * static_cast<std::size_t>((height + 1) / 2);
+    return luma_size + 2 * chroma_size;
+}
+
+void convert_argb8888_to_i420(
+    const void* pixels, int pitch, int width, int height, std::span<std::uint8_t> destination
+) noexcept
+{
+    const auto chroma_width = static_cast<std::size_t>((width + 1) / 2);
+    const auto chroma_height = static_cast<std::size_t>((height + 1) / 2);
+    std::uint8_t* const luma_plane = destination.data();
+    std::uint8_t* const u_plane = luma_plane + static_cast<std::size_t>(width) * static_cast<std::size_t>(height);
+    std::uint8_t* const v_plane = u_plane + chroma_width * chroma_height;
+
+    for (int y = 0; y < height; ++y) {
+        convert_luma_row(pixel_row(pixels, pitch, y), width, luma_plane + static_cast<std::size_t>(y) * width);
+    }
+    for (int y = 0; y < height; y += 2) {
+        const auto chroma_offset = static_cast<std::size_t>(y / 2) * chroma_width;
+        convert_chroma_row(
+            pixel_row(pixels, pitch, y),
+            pixel_row(pixels, pitch, std::min(y + 1, height - 1)),
+            width,
+            u_plane + chroma_offset,
+            v_plane + chroma_offset
+        );
+    }
+}
+
+FrameRecorder::FrameRecorder(RWOps destination, int width, int height, RecorderConfig config)
+    : destination_{std::move(destination)},
+      width_{width},
+      height_{height},
+      config_{config},
+      surface_pool_{config.max_pending_frames},
+      start_time_{std::chrono::steady_clock::now()}
+{
+    write_buffer_.reserve(config_.write_buffer_size);
+    if (config_.container == VideoContainer::y4m) {
+        const std::string header = y4m_header(width_, height_, config_);
+        append(std::span{reinterpret_cast<const std::uint8_t*>(header.data()), header.size()});
+    }
+
+    const std::size_t n_workers = std::max(config_.n_workers, std::size_t{1});
+    workers_.reserve(n_workers);
+    for (std::size_t i = 0; i < n_workers; ++i) {
+        workers_.emplace_back(&FrameRecorder::convert, this);
+    }
+    writer_ = std::thread{&FrameRecorder::write, this};
+}
+
+FrameRecorder::~FrameRecorder()
+{
+    stop();
+}
+
+bool FrameRecorder::record(const Renderer& renderer)
+{
+    // the slot is taken before reading back, so a dropped frame never pays for the GPU stall
+    {
+        std::unique_lock lock{mutex_};
+        const bool has_slot = frame_written_.wait_for(lock, config_.submit_budget, [this] {
+            return stopping_ || next_sequence_ + n_reading_ - next_written_sequence_ < config_.max_pending_frames;
+        });
+        if (!has_slot || stopping_) {
+            ++n_dropped_;
+            return false;
+        }
+        ++n_reading_;
+    }
+
+    SurfaceUniquePtr surface;
+    try {
+        surface = surface_pool_.acquire(width_, height_, SDL_PIXELFORMAT_ARGB8888);
+        const Rectangle<int> area{0, 0, width_, height_};
+        renderer.read_pixels(&area, SDL_PIXELFORMAT_ARGB8888, surface->pixels, surface->pitch);
+    } catch (...) {
+        std::lock_guard lock{mutex_};
+        --n_reading_;
+        throw;
+    }
+
+    std::unique_lock lock{mutex_};
+    --n_reading_;
+    if (stopping_) {
+        ++n_dropped_;
+        lock.unlock();
+        surface_pool_.release(std::move(surface));
+        return false;
+    }
+    read_frames_.push_back(PendingFrame{next_sequence_++, std::move(surface)});
+    lock.unlock();
+    frame_read_.notify_one();
+    return true;
+}
+
+void FrameRecorder::finish()
+{
+    stop();
+    std::lock_guard lock{mutex_};
+    if (error_) {
+        std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+}
+
+FrameRecorder::Statistics FrameRecorder::statistics() const
+{
+    std::lock_guard lock{mutex_};
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time_;
+    const double megabytes = static_cast<double>(n_bytes_written_) / (1024.0 * 1024.0);
+    return Statistics{
+        next_written_sequence_,
+        n_dropped_,
+        n_bytes_written_,
+        elapsed.count() > 0.0 ? megabytes / elapsed.count() : 0.0,
+    };
+}
+
+void FrameRecorder::convert()
+{
+    const std::size_t frame_size = i420_frame_size(width_, height_);
+    while (true) {
+        PendingFrame frame;
+        std::vector<std::uint8_t> buffer;
+        {
+            std::unique_lock lock{mutex_};
+            frame_read_.wait(lock, [this] { return stopping_ || !read_frames_.empty(); });
+            if (read_frames_.empty()) {
+                return;
+            }
+            frame = std::move(read_frames_.front());
+            read_frames_.pop_front();
+            if (!free_frame_buffers_.empty()) {
+                buffer = std::move(free_frame_buffers_.back());
+                free_frame_buffers_.pop_back();
+            }
+        }
+
+        buffer.resize(frame_size);
+        convert_argb8888_to_i420(frame.surface->pixels, frame.surface->pitch, width_, height_, buffer);
+        surface_pool_.release(std::move(frame.surface));
+
+        {
+            std::lock_guard lock{mutex_};
+            converted_frames_.emplace(frame.sequence, std::move(buffer));
+        }
+        frame_converted_.notify_one();
+    }
+}
+
+void FrameRecorder::write()
+{
+    while (true) {
+        std::vector<std::uint8_t> frame;
+        {
+            std::unique_lock lock{mutex_};
+            frame_converted_.wait(lock, [this] {
+                return converted_frames_.contains(next_written_sequence_) ||
+                       (stopping_ && next_written_sequence_ == next_sequence_);
+            });
+            const auto found = converted_frames_.find(next_written_sequence_);
+            if (found == converted_frames_.end()) {
+                break;
+            }
+            frame = std::move(found->second);
+            converted_frames_.erase(found);
+        }
+
+        // only bytes that were actually appended count as written
+        std::size_t n_bytes = 0;
+        try {
+            if (config_.container == VideoContainer::y4m) {
+                const auto* header = reinterpret_cast<const std::uint8_t*>(y4m_frame_header.data());
+                append(std::span{header, y4m_frame_header.size()});
+                n_bytes += y4m_frame_header.size();
+            }
+            append(frame);
+            n_bytes += frame.size();
+        } catch (...) {
+            std::lock_guard lock{mutex_};
+            if (!error_) {
+                error_ = std::current_exception();
+            }
+        }
+
+        {
+            std::lock_guard lock{mutex_};
+            ++next_written_sequence_;
+            n_bytes_written_ += n_bytes;
+            free_frame_buffers_.push_back(std::move(frame));
+        }
+        frame_written_.notify_all();
+    }
+
+    try {
+        flush_write_buffer();
+    } catch (...) {
+        std::lock_guard lock{mutex_};
+        if (!error_) {
+            error_ = std::current_exception();
+        }
+    }
+}
+
+void FrameRecorder::stop() noexcept
+{
+    {
+        std::lock_guard lock{mutex_};
+        if (stopping_) {
+            return;
+        }
+        stopping_ = true;
+    }
+    frame_read_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+    frame_converted_.notify_one();
+    frame_written_.notify_all();
+    writer_.join();
+}
+
+void FrameRecorder::append(std::span<const std::uint8_t> bytes)
+{
+    if (write_buffer_.size() + bytes.size() > config_.write_buffer_size) {
+        flush_write_buffer();
+    }
+    if (bytes.size() >= config_.write_buffer_size) {
+        destination_.write(bytes.data(), 1, bytes.size());
+        return;
+    }
+    write_buffer_.insert(write_buffer_.end(), bytes.begin(), bytes.end());
+}
+
+void FrameRecorder::flush_write_buffer()
+{
+    if (!write_buffer_.empty()) {
+        destination_.write(write_buffer_.data(), 1, write_buffer_.size());
+        write_buffer_.clear();
+    }
+}
+
+} // namespace sdl
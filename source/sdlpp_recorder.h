@@ -0,0 +1,121 @@
+#pragma once
+
+#include "sdlpp.h"
+#include "sdlpp_capture.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace sdl {
+
+// Size in bytes of a planar I420 (YUV 4:2:0) frame; chroma planes are rounded up for odd dimensions.
+[[nodiscard]] std::size_t i420_frame_size(int width, int height) noexcept;
+
+// Converts `width` x `height` ARGB8888 pixels to full-range BT.601 I420 planes laid out back to back in
+// `destination`, which must hold i420_frame_size(width, height) bytes. Uses SSE2 when available.
+void convert_argb8888_to_i420(
+    const void* pixels, int pitch, int width, int height, std::span<std::uint8_t> destination
+) noexcept;
+
+enum class VideoContainer
+{
+    // YUV4MPEG2 stream with a per-frame header, readable by ffmpeg/mpv
+    y4m,
+    // I420 planes only, frame after frame
+    raw,
+};
+
+struct RecorderConfig
+{
+    VideoContainer container = VideoContainer::y4m;
+    int frame_rate_numerator = 60;
+    int frame_rate_denominator = 1;
+    std::size_t n_workers = 2;
+    // frames read back but not yet written
+    std::size_t max_pending_frames = 8;
+    // how long record() may wait for a pending slot before dropping the frame
+    std::chrono::microseconds submit_budget{1000};
+    // bytes collected before each write to the destination
+    std::size_t write_buffer_size = std::size_t{8} << 20U;
+};
+
+// Records every frame of a renderer to a video stream. record() only reads back the frame on the calling thread; I420
+// conversion runs on worker threads and a writer thread streams frames in order through a write-behind buffer.
+class FrameRecorder
+{
+  public:
+    struct Statistics
+    {
+        std::uint64_t n_recorded;
+        std::uint64_t n_dropped;
+        std::uint64_t n_bytes_written;
+        double megabytes_per_second;
+    };
+
+    FrameRecorder(RWOps destination, int width, int height, RecorderConfig config = {});
+    FrameRecorder(const FrameRecorder&) = delete;
+    FrameRecorder& operator=(const FrameRecorder&) = delete;
+    ~FrameRecorder();
+
+    // reads back the top-left width x height pixels of the current render target; returns false if the frame was
+    // dropped because the pipeline stayed full for longer than the submit budget
+    bool record(const Renderer& renderer);
+
+    // writes every accepted frame and stops the pipeline; rethrows the first write error
+    void finish();
+
+    [[nodiscard]] Statistics statistics() const;
+
+  private:
+    struct PendingFrame
+    {
+        std::uint64_t sequence;
+        SurfaceUniquePtr surface;
+    };
+
+    void convert();
+    void write();
+    void stop() noexcept;
+    void append(std::span<const std::uint8_t> bytes);
+    void flush_write_buffer();
+
+    RWOps destination_;
+    int width_;
+    int height_;
+    RecorderConfig config_;
+    SurfacePool surface_pool_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable frame_read_;
+    std::condition_variable frame_converted_;
+    std::condition_variable frame_written_;
+    std::deque<PendingFrame> read_frames_;
+    std::map<std::uint64_t, std::vector<std::uint8_t>> converted_frames_;
+    std::vector<std::vector<std::uint8_t>> free_frame_buffers_;
+    std::uint64_t next_sequence_{0};
+    // frames record() holds a slot for while it reads them back, before they get a sequence number
+    std::uint64_t n_reading_{0};
+    std::uint64_t next_written_sequence_{0};
+    std::uint64_t n_dropped_{0};
+    std::uint64_t n_bytes_written_{0};
+    std::chrono::steady_clock::time_point start_time_;
+    std::exception_ptr error_;
+    bool stopping_{false};
+
+    // touched only by the writer thread, and by the constructor before it starts
+    std::vector<std::uint8_t> write_buffer_;
+
+    std::vector<std::thread> workers_;
+    std::thread writer_;
+};
+
+} // namespace sdl
@@ -0,0 +1,292 @@
+#include "sdlpp_render_thread.h"
+
+#include "sdlpp.h"
+
+#include <optional>
+#include <utility>
+
+namespace sdl {
+
+namespace detail {
+
+class TextureGraveyard
+{
+  public:
+    void bury(Texture* texture) noexcept
+    {
+        std::unique_ptr<Texture> owned{texture};
+        std::lock_guard lock{mutex_};
+        if (closed_) {
+            // the renderer is gone and has already destroyed every texture it owned, so only the accounting record is
+            // left to drop
+            SDL_Texture* const destroyed = owned->release().release();
+            SDLWRAP_UNTRACK(accounting::ResourceType::texture, destroyed);
+            static_cast<void>(destroyed);
+            return;
+        }
+        dead_.push_back(std::move(owned));
+    }
+
+    // destroys parked textures; must run on the render thread
+    void clear() noexcept
+    {
+        std::vector<std::unique_ptr<Texture>> dead;
+        {
+            std::lock_guard lock{mutex_};
+            dead.swap(dead_);
+        }
+    }
+
+    // destroys parked textures and stops accepting new ones; must run on the render thread before the renderer is
+    // destroyed
+    void close() noexcept
+    {
+        std::lock_guard lock{mutex_};
+        dead_.clear();
+        closed_ = true;
+    }
+
+  private:
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<Texture>> dead_;
+    bool closed_{false};
+};
+
+} // namespace detail
+
+namespace {
+
+class CommandExecutor
+{
+  public:
+    CommandExecutor(Renderer& renderer, std::span<const Rectangle<float>> rectangles) noexcept
+        : renderer_{renderer}, rectangles_{rectangles}
+    {}
+
+    void operator()(const render_command::Clear&) const
+    {
+        renderer_.clear();
+    }
+
+    void operator()(const render_command::SetDrawColor& command) const
+    {
+        renderer_.set_draw_color(command.color);
+    }
+
+    void operator()(const render_command::SetDrawBlendMode& command) const
+    {
+        renderer_.set_draw_blend_mode(command.mode);
+    }
+
+    void operator()(const render_command::SetRenderTarget& command) const
+    {
+        renderer_.set_render_target(command.target ? command.target->get_pointer() : nullptr);
+    }
+
+    void operator()(const render_command::Copy& command) const
+    {
+        if (command.texture) {
+            renderer_.copy(*command.texture, command.source, command.destination);
+        }
+    }
+
+    void operator()(const render_command::FillRectangles& command) const
+    {
+        renderer_.fill_rectangles(rectangles_.subspan(command.first, command.count));
+    }
+
+    void operator()(render_command::CreateTexture& command) const
+    {
+        *command.texture = Texture{renderer_.make_texture(command.properties)};
+    }
+
+    void operator()(render_command::CreateTextureFromSurface& command) const
+    {
+        *command.texture = Texture{renderer_.make_texture_from_surface(command.surface.get())};
+        command.surface.reset();
+    }
+
+    void operator()(const render_command::Invoke& command) const
+    {
+        command.function(renderer_);
+    }
+
+  private:
+    Renderer& renderer_;
+    std::span<const Rectangle<float>> rectangles_;
+};
+
+} // namespace
+
+void CommandList::fill_rectangles(std::span<const Rectangle<float>> rectangles)
+{
+    commands_.push_back(render_command::FillRectangles{rectangles_.size(), rectangles.size()});
+    rectangles_.insert(rectangles_.end(), rectangles.begin(), rectangles.end());
+}
+
+TextureHandle CommandList::make_texture_handle()
+{
+    return TextureHandle{new Texture{}, [graveyard = graveyard_](Texture* texture) { graveyard->bury(texture); }};
+}
+
+TextureHandle CommandList::make_texture(const Texture::Properties& properties)
+{
+    TextureHandle texture = make_texture_handle();
+    commands_.push_back(render_command::CreateTexture{texture, properties});
+    return texture;
+}
+
+TextureHandle CommandList::make_texture_from_surface(SurfaceUniquePtr surface)
+{
+    TextureHandle texture = make_texture_handle();
+    commands_.push_back(render_command::CreateTextureFromSurface{texture, std::move(surface)});
+    return texture;
+}
+
+void CommandList::execute(Renderer& renderer)
+{
+    const CommandExecutor executor{renderer, rectangles_};
+    for (RenderCommand& command : commands_) {
+        std::visit(executor, command);
+    }
+}
+
+void CommandList::reset() noexcept
+{
+    commands_.clear();
+    rectangles_.clear();
+}
+
+RenderThread::RenderThread(SDL_Window* window, const RendererConfig& config, std::size_t frames_in_flight)
+    : frames_in_flight_{frames_in_flight == 0 ? 1 : frames_in_flight},
+      graveyard_{std::make_shared<detail::TextureGraveyard>()}
+{
+    std::promise<void> started;
+    std::future<void> renderer_created = started.get_future();
+    thread_ = std::thread{&RenderThread::run, this, window, config, std::move(started)};
+    try {
+        renderer_created.get();
+    } catch (...) {
+        thread_.join();
+        throw;
+    }
+}
+
+RenderThread::~RenderThread()
+{
+    {
+        std::lock_guard lock{mutex_};
+        stopping_ = true;
+    }
+    frame_queued_.notify_one();
+    thread_.join();
+}
+
+CommandList RenderThread::make_command_list()
+{
+    std::lock_guard lock{mutex_};
+    if (free_lists_.empty()) {
+        return CommandList{graveyard_};
+    }
+    CommandList list = std::move(free_lists_.back());
+    free_lists_.pop_back();
+    return list;
+}
+
+void RenderThread::submit(CommandList list)
+{
+    std::lock_guard lock{mutex_};
+    recording_.push_back(std::move(list));
+}
+
+FrameFence RenderThread::end_frame()
+{
+    std::unique_lock lock{mutex_};
+    frame_completed_.wait(lock, [this] { return queued_.size() + n_executing_ < frames_in_flight_; });
+    rethrow_pending_error();
+    const FrameFence fence = next_fence_++;
+    queued_.push_back(Frame{fence, std::exchange(recording_, {})});
+    lock.unlock();
+    frame_queued_.notify_one();
+    return fence;
+}
+
+bool RenderThread::is_complete(FrameFence fence) const
+{
+    std::lock_guard lock{mutex_};
+    return completed_fence_ >= fence;
+}
+
+void RenderThread::wait(FrameFence fence) const
+{
+    std::unique_lock lock{mutex_};
+    frame_completed_.wait(lock, [this, fence] { return completed_fence_ >= fence; });
+}
+
+void RenderThread::run(SDL_Window* window, RendererConfig config, std::promise<void> started)
+{
+    std::optional<Renderer> renderer;
+    try {
+        renderer.emplace(window, config);
+    } catch (...) {
+        started.set_exception(std::current_exception());
+        return;
+    }
+    started.set_value();
+
+    while (true) {
+        Frame frame;
+        {
+            std::unique_lock lock{mutex_};
+            frame_queued_.wait(lock, [this] { return stopping_ || !queued_.empty(); });
+            if (queued_.empty()) {
+                break;
+            }
+            frame = std::move(queued_.front());
+            queued_.pop_front();
+            ++n_executing_;
+        }
+        execute(*renderer, frame);
+    }
+
+    graveyard_->close();
+}
+
+void RenderThread::execute(Renderer& renderer, Frame& frame)
+{
+    try {
+        for (CommandList& list : frame.lists) {
+            list.execute(renderer);
+        }
+        renderer.present();
+    } catch (...) {
+        std::lock_guard lock{mutex_};
+        if (!error_) {
+            error_ = std::current_exception();
+        }
+    }
+
+    for (CommandList& list : frame.lists) {
+        list.reset();
+    }
+    graveyard_->clear();
+
+    {
+        std::lock_guard lock{mutex_};
+        completed_fence_ = frame.fence;
+        --n_executing_;
+        for (CommandList& list : frame.lists) {
+            free_lists_.push_back(std::move(list));
+        }
+    }
+    frame_completed_.notify_all();
+}
+
+void RenderThread::rethrow_pending_error()
+{
+    if (error_) {
+        std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+}
+
+} // namespace sdl
@@ -0,0 +1,220 @@
+#pragma once
+
+#include "sdlpp.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <variant>
+#include <vector>
+
+namespace sdl {
+
+namespace detail {
+// Textures created through a RenderThread are destroyed on the render thread: releasing the last handle from a
+// producer thread only parks the texture here until the next frame is executed.
+class TextureGraveyard;
+} // namespace detail
+
+using TextureHandle = std::shared_ptr<Texture>;
+
+namespace render_command {
+
+struct Clear
+{};
+
+struct SetDrawColor
+{
+    Color color;
+};
+
+struct SetDrawBlendMode
+{
+    SDL_BlendMode mode;
+};
+
+// a null target selects the default render target
+struct SetRenderTarget
+{
+    TextureHandle target;
+};
+
+// a null texture draws nothing
+struct Copy
+{
+    TextureHandle texture;
+    Rectangle<int> source;
+    Rectangle<float> destination;
+};
+
+struct FillRectangles
+{
+    std::size_t first;
+    std::size_t count;
+};
+
+struct CreateTexture
+{
+    TextureHandle texture;
+    Texture::Properties properties;
+};
+
+struct CreateTextureFromSurface
+{
+    TextureHandle texture;
+    SurfaceUniquePtr surface;
+};
+
+struct Invoke
+{
+    std::function<void(Renderer&)> function;
+};
+
+} // namespace render_command
+
+using RenderCommand = std::variant<
+    render_command::Clear,
+    render_command::SetDrawColor,
+    render_command::SetDrawBlendMode,
+    render_command::SetRenderTarget,
+    render_command::Copy,
+    render_command::FillRectangles,
+    render_command::CreateTexture,
+    render_command::CreateTextureFromSurface,
+    render_command::Invoke>;
+
+// Commands recorded by a single thread. Lists are not synchronized; record into one list per producer thread and
+// hand it to RenderThread::submit when done. Texture handles returned by make_texture* are usable in later commands
+// right away, but their contents may only be inspected once the frame that created them has completed.
+class CommandList
+{
+  public:
+    void clear()
+    {
+        commands_.push_back(render_command::Clear{});
+    }
+
+    void set_draw_color(const Color& color)
+    {
+        commands_.push_back(render_command::SetDrawColor{color});
+    }
+
+    void set_draw_blend_mode(SDL_BlendMode mode)
+    {
+        commands_.push_back(render_command::SetDrawBlendMode{mode});
+    }
+
+    void set_render_target(TextureHandle target)
+    {
+        commands_.push_back(render_command::SetRenderTarget{std::move(target)});
+    }
+
+    void copy(TextureHandle texture, const Rectangle<int>& source, const Rectangle<float>& destination)
+    {
+        commands_.push_back(render_command::Copy{std::move(texture), source, destination});
+    }
+
+    void fill_rectangles(std::span<const Rectangle<float>> rectangles);
+
+    // runs `function` on the render thread with the owning renderer
+    void invoke(std::function<void(Renderer&)> function)
+    {
+        commands_.push_back(render_command::Invoke{std::move(function)});
+    }
+
+    [[nodiscard]] TextureHandle make_texture(const Texture::Properties& properties);
+    [[nodiscard]] TextureHandle make_texture_from_surface(SurfaceUniquePtr surface);
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+        return commands_.empty();
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept
+    {
+        return commands_.size();
+    }
+
+  private:
+    friend class RenderThread;
+
+    CommandList(std::shared_ptr<detail::TextureGraveyard> graveyard) noexcept : graveyard_{std::move(graveyard)} {}
+
+    [[nodiscard]] TextureHandle make_texture_handle();
+    void execute(Renderer& renderer);
+    void reset() noexcept;
+
+    std::shared_ptr<detail::TextureGraveyard> graveyard_;
+    std::vector<RenderCommand> commands_;
+    std::vector<Rectangle<float>> rectangles_;
+};
+
+using FrameFence = std::uint64_t;
+
+// Owns a renderer driven from a dedicated thread. Any thread records commands into CommandLists and submits them to
+// the frame currently being recorded; end_frame hands that frame to the render thread, which executes the lists in
+// submission order and presents. Up to `frames_in_flight` frames may be queued or executing, so producers only wait
+// when they are that many frames ahead of the render thread, never on an individual present.
+class RenderThread
+{
+  public:
+    static constexpr std::size_t default_frames_in_flight = 3;
+
+    // the renderer is created on the render thread; errors creating it are rethrown here
+    RenderThread(SDL_Window* window, const RendererConfig& config,
+                 std::size_t frames_in_flight = default_frames_in_flight);
+    RenderThread(const RenderThread&) = delete;
+    RenderThread& operator=(const RenderThread&) = delete;
+    ~RenderThread();
+
+    // returns an empty list, reusing the storage of a previously executed one when available
+    [[nodiscard]] CommandList make_command_list();
+
+    // appends `list` to the frame being recorded; thread-safe
+    void submit(CommandList list);
+
+    // closes the frame being recorded and queues it for execution. Blocks only while `frames_in_flight` frames are
+    // already queued or executing. Rethrows the first error raised while executing an earlier frame.
+    FrameFence end_frame();
+
+    [[nodiscard]] bool is_complete(FrameFence fence) const;
+    void wait(FrameFence fence) const;
+
+  private:
+    struct Frame
+    {
+        FrameFence fence;
+        std::vector<CommandList> lists;
+    };
+
+    void run(SDL_Window* window, RendererConfig config, std::promise<void> started);
+    void execute(Renderer& renderer, Frame& frame);
+    void rethrow_pending_error();
+
+    std::size_t frames_in_flight_;
+    std::shared_ptr<detail::TextureGraveyard> graveyard_;
+
+    mutable std::mutex mutex_;
+    mutable std::condition_variable frame_queued_;
+    mutable std::condition_variable frame_completed_;
+    std::vector<CommandList> recording_;
+    std::deque<Frame> queued_;
+    std::vector<CommandList> free_lists_;
+    FrameFence next_fence_{1};
+    FrameFence completed_fence_{0};
+    std::size_t n_executing_{0};
+    std::exception_ptr error_;
+    bool stopping_{false};
+
+    std::thread thread_;
+};
+
+} // namespace sdl
@@ -0,0 +1,231 @@
+#include "sdlpp_tilemap.h"
+
+#include "sdlpp.h"
+
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+
+namespace sdl {
+
+namespace {
+
+int divide_rounding_up(int numerator, int denominator) noexcept
+{
+    return (numerator + denominator - 1) / denominator;
+}
+
+const TilemapConfig& validate(const TilemapConfig& config)
+{
+    if (config.size.x < 0 || config.size.y < 0) {
+        throw std::invalid_argument{"tile map size must not be negative"};
+    }
+    if (config.tile_size.x <= 0 || config.tile_size.y <= 0) {
+        throw std::invalid_argument{"tile size must be positive"};
+    }
+    if (config.chunk_size <= 0) {
+        throw std::invalid_argument{"chunk size must be positive"};
+    }
+    return config;
+}
+
+SDL_BlendMode get_blend_mode(SDL_Texture& texture)
+{
+    SDL_BlendMode mode = SDL_BLENDMODE_NONE;
+    if (SDL_GetTextureBlendMode(&texture, &mode) != 0) {
+        throw GenericError{};
+    }
+    return mode;
+}
+
+void set_blend_mode(SDL_Texture& texture, SDL_BlendMode mode)
+{
+    if (SDL_SetTextureBlendMode(&texture, mode) != 0) {
+        throw GenericError{};
+    }
+}
+
+} // namespace
+
+Tilemap::Tilemap(const TilemapConfig& config)
+    : config_{validate(config)},
+      n_chunks_{
+          divide_rounding_up(config.size.x, config.chunk_size), divide_rounding_up(config.size.y, config.chunk_size)
+      },
+      tile_sources_(1, TileSource{nullptr, {}}),
+      tiles_(static_cast<std::size_t>(config.size.x) * static_cast<std::size_t>(config.size.y), empty_tile),
+      chunks_(static_cast<std::size_t>(n_chunks_.x) * static_cast<std::size_t>(n_chunks_.y))
+{}
+
+TileId Tilemap::add_tile(SDL_Texture& texture, const Rectangle<int>& source)
+{
+    if (tile_sources_.size() > std::numeric_limits<TileId>::max()) {
+        throw std::length_error{"too many tiles"};
+    }
+    tile_sources_.push_back(TileSource{&texture, source});
+    return static_cast<TileId>(tile_sources_.size() - 1);
+}
+
+void Tilemap::set_tile(Point<int> position, TileId tile)
+{
+    if (tile >= tile_sources_.size()) {
+        throw std::out_of_range{"tile was not added to the map"};
+    }
+    TileId& current = tiles_[tile_index(position)];
+    if (current == tile) {
+        return;
+    }
+    current = tile;
+    chunks_[chunk_index({position.x / config_.chunk_size, position.y / config_.chunk_size})].dirty = true;
+}
+
+TileId Tilemap::get_tile(Point<int> position) const
+{
+    return tiles_[tile_index(position)];
+}
+
+void Tilemap::draw(Renderer& renderer, const Rectangle<int>& camera, Point<int> screen_position)
+{
+    ++frame_;
+    const Point<int> chunk_pixels{config_.chunk_size * config_.tile_size.x, config_.chunk_size * config_.tile_size.y};
+    const int first_x = std::max(camera.x / chunk_pixels.x, 0);
+    const int first_y = std::max(camera.y / chunk_pixels.y, 0);
+    const int last_x = std::min(divide_rounding_up(camera.x + camera.w, chunk_pixels.x), n_chunks_.x);
+    const int last_y = std::min(divide_rounding_up(camera.y + camera.h, chunk_pixels.y), n_chunks_.y);
+
+    for (int y = first_y; y < last_y; ++y) {
+        for (int x = first_x; x < last_x; ++x) {
+            Chunk& chunk = chunks_[chunk_index({x, y})];
+            if (chunk.dirty || chunk.texture.get_pointer() == nullptr) {
+                render_chunk(renderer, {x, y}, chunk);
+            }
+            chunk.last_drawn_frame = frame_;
+
+            const Rectangle<int> source{0, 0, chunk_pixels.x, chunk_pixels.y};
+            const Rectangle<int> destination{
+                x * chunk_pixels.x - camera.x + screen_position.x,
+                y * chunk_pixels.y - camera.y + screen_position.y,
+                chunk_pixels.x,
+                chunk_pixels.y,
+            };
+            renderer.copy(chunk.texture, source, destination);
+        }
+    }
+
+    evict_chunks();
+}
+
+void Tilemap::invalidate() noexcept
+{
+    for (Chunk& chunk : chunks_) {
+        chunk.dirty = true;
+    }
+}
+
+std::size_t Tilemap::tile_index(Point<int> position) const
+{
+    if (position.x < 0 || position.y < 0 || position.x >= config_.size.x || position.y >= config_.size.y) {
+        throw std::out_of_range{"tile position outside the map"};
+    }
+    return static_cast<std::size_t>(position.y) * static_cast<std::size_t>(config_.size.x) +
+           static_cast<std::size_t>(position.x);
+}
+
+std::size_t Tilemap::chunk_index(Point<int> chunk) const noexcept
+{
+    return static_cast<std::size_t>(chunk.y) * static_cast<std::size_t>(n_chunks_.x) +
+           static_cast<std::size_t>(chunk.x);
+}
+
+Rectangle<int> Tilemap::chunk_tiles(Point<int> chunk) const noexcept
+{
+    const int x = chunk.x * config_.chunk_size;
+    const int y = chunk.y * config_.chunk_size;
+    return {x, y, std::min(config_.chunk_size, config_.size.x - x), std::min(config_.chunk_size, config_.size.y - y)};
+}
+
+void Tilemap::render_chunk(Renderer& renderer, Point<int> chunk_position, Chunk& chunk)
+{
+    if (chunk.texture.get_pointer() == nullptr) {
+        chunk.texture = Texture{renderer.make_texture(
+            SDL_PIXELFORMAT_ARGB8888,
+            SDL_TEXTUREACCESS_TARGET,
+            config_.chunk_size * config_.tile_size.x,
+            config_.chunk_size * config_.tile_size.y
+        )};
+        set_blend_mode(*chunk.texture.get_pointer(), SDL_BLENDMODE_BLEND);
+        ++n_cached_chunks_;
+    }
+
+    // switching targets resets the viewport and clip rectangle, so those are restored along with the target
+    SDL_Texture* const saved_target = renderer.get_render_target();
+    const Rectangle<int> saved_viewport = renderer.get_viewport();
+    const std::optional<Rectangle<int>> saved_clip = renderer.get_clip_rectangle();
+    const Color saved_color = renderer.get_draw_color();
+    renderer.set_render_target(chunk.texture.get_pointer());
+    renderer.set_draw_color({0, 0, 0, 0});
+    renderer.clear();
+
+    // Tiles never overlap within a chunk, so they are copied without blending. That keeps the chunk's colors straight
+    // rather than premultiplied, and SDL_BLENDMODE_BLEND, which every renderer supports, then draws it like the tiles.
+    SDL_Texture* unblended = nullptr;
+    SDL_BlendMode saved_blend_mode = SDL_BLENDMODE_NONE;
+    const Rectangle<int> tiles = chunk_tiles(chunk_position);
+    for (int y = 0; y < tiles.h; ++y) {
+        for (int x = 0; x < tiles.w; ++x) {
+            const TileId tile = tiles_[tile_index({tiles.x + x, tiles.y + y})];
+            if (tile == empty_tile) {
+                continue;
+            }
+            const TileSource& source = tile_sources_[tile];
+            if (source.texture != unblended) {
+                if (unblended != nullptr) {
+                    set_blend_mode(*unblended, saved_blend_mode);
+                }
+                unblended = source.texture;
+                saved_blend_mode = get_blend_mode(*unblended);
+                set_blend_mode(*unblended, SDL_BLENDMODE_NONE);
+            }
+            const Rectangle<int> destination{
+                x * config_.tile_size.x, y * config_.tile_size.y, config_.tile_size.x, config_.tile_size.y
+            };
+            renderer.copy(*source.texture, source.source, destination);
+        }
+    }
+    if (unblended != nullptr) {
+        set_blend_mode(*unblended, saved_blend_mode);
+    }
+
+    renderer.set_render_target(saved_target);
+    renderer.set_viewport(saved_viewport);
+    renderer.set_clip_rectangle(saved_clip ? &*saved_clip : nullptr);
+    renderer.set_draw_color(saved_color);
+    chunk.dirty = false;
+}
+
+void Tilemap::evict_chunks()
+{
+    if (n_cached_chunks_ <= config_.max_cached_chunks) {
+        return;
+    }
+    std::vector<Chunk*> cached;
+    cached.reserve(n_cached_chunks_);
+    for (Chunk& chunk : chunks_) {
+        if (chunk.texture.get_pointer() != nullptr && chunk.last_drawn_frame != frame_) {
+            cached.push_back(&chunk);
+        }
+    }
+    const std::size_t n_evicted = std::min(n_cached_chunks_ - config_.max_cached_chunks, cached.size());
+    const auto evicted_end = cached.begin() + static_cast<std::ptrdiff_t>(n_evicted);
+    std::partial_sort(cached.begin(), evicted_end, cached.end(), [](const Chunk* lhs, const Chunk* rhs) {
+        return lhs->last_drawn_frame < rhs->last_drawn_frame;
+    });
+    for (std::size_t i = 0; i < n_evicted; ++i) {
+        cached[i]->texture = Texture{};
+        cached[i]->dirty = true;
+    }
+    n_cached_chunks_ -= n_evicted;
+}
+
+} // namespace sdl
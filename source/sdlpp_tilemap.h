@@ -0,0 +1,92 @@
+#pragma once
+
+#include "sdlpp.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace sdl {
+
+using TileId = std::uint16_t;
+
+struct TilemapConfig
+{
+    // map dimensions in tiles
+    Point<int> size;
+    // tile dimensions in pixels
+    Point<int> tile_size;
+    // chunk edge length in tiles
+    int chunk_size = 32;
+    // chunk textures kept alive; the least recently drawn chunks beyond this are released
+    std::size_t max_cached_chunks = 256;
+};
+
+// Tile map drawn from cached per-chunk render target textures. Each chunk is rendered tile by tile only when first
+// drawn or after one of its tiles changed; a frame then costs one copy per chunk intersecting the camera.
+class Tilemap
+{
+  public:
+    static constexpr TileId empty_tile = 0;
+
+    Tilemap(const TilemapConfig& config);
+
+    // registers a tile drawn from `source` in `texture` and returns its id; the texture must outlive the map, and its
+    // blend mode is briefly switched to none while chunks are rebuilt
+    TileId add_tile(SDL_Texture& texture, const Rectangle<int>& source);
+
+    // throws std::out_of_range for a position outside the map or an id add_tile did not return
+    void set_tile(Point<int> position, TileId tile);
+    [[nodiscard]] TileId get_tile(Point<int> position) const;
+
+    // draws the `camera` region of the map, in map pixels, with its top-left corner at `screen_position`
+    void draw(Renderer& renderer, const Rectangle<int>& camera, Point<int> screen_position = {0, 0});
+
+    // forces every chunk to be re-rendered, e.g. after SDL_RENDER_TARGETS_RESET
+    void invalidate() noexcept;
+
+    [[nodiscard]] Point<int> size() const noexcept
+    {
+        return config_.size;
+    }
+
+    [[nodiscard]] Point<int> size_in_pixels() const noexcept
+    {
+        return {config_.size.x * config_.tile_size.x, config_.size.y * config_.tile_size.y};
+    }
+
+    [[nodiscard]] std::size_t n_cached_chunks() const noexcept
+    {
+        return n_cached_chunks_;
+    }
+
+  private:
+    struct TileSource
+    {
+        SDL_Texture* texture;
+        Rectangle<int> source;
+    };
+
+    struct Chunk
+    {
+        Texture texture;
+        bool dirty{true};
+        std::uint64_t last_drawn_frame{0};
+    };
+
+    [[nodiscard]] std::size_t tile_index(Point<int> position) const;
+    [[nodiscard]] std::size_t chunk_index(Point<int> chunk) const noexcept;
+    [[nodiscard]] Rectangle<int> chunk_tiles(Point<int> chunk) const noexcept;
+    void render_chunk(Renderer& renderer, Point<int> chunk_position, Chunk& chunk);
+    void evict_chunks();
+
+    TilemapConfig config_;
+    Point<int> n_chunks_;
+    std::vector<TileSource> tile_sources_;
+    std::vector<TileId> tiles_;
+    std::vector<Chunk> chunks_;
+    std::size_t n_cached_chunks_{0};
+    std::uint64_t frame_{0};
+};
+
+} // namespace sdl